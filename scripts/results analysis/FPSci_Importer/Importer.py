@@ -41,10 +41,21 @@ class QuestionResponse:
         self.response = response
 
 class FrameInfo:
-    def __init__(self, time, sdt, idt):
+    def __init__(self, time, sdt, idt, frameIndex=None, rdt=None, inputTime=None, simTime=None, poseTime=None, waitTime=None, graphicsTime=None, inputToSubmitTime=None, predictedCost=None, actualCost=None):
         self.time = time
         self.sdt = float(sdt)
         self.idt = float(idt)
+        # Per-phase timing (not present in older results files)
+        self.frameIndex = frameIndex
+        self.rdt = rdt
+        self.inputTime = inputTime
+        self.simTime = simTime
+        self.poseTime = poseTime
+        self.waitTime = waitTime
+        self.graphicsTime = graphicsTime
+        self.inputToSubmitTime = inputToSubmitTime
+        self.predictedCost = predictedCost
+        self.actualCost = actualCost
 
 class Event:
     def __init__(self, time, eventType):
@@ -221,7 +232,7 @@ class Importer:
         """Get the frame info table as a list"""
         frames = []
         for row in self.getTableRows('Frame_Info'):
-            frames.append(FrameInfo(row[0], row[2], row[1]))
+            frames.append(FrameInfo(row[0], row[2], row[1], *row[3:]))
         return frames
 
     def parseTime(self, timeStr):
@@ -0,0 +1,113 @@
+#include "AimAgent.h"
+#include "PlayerEntity.h"
+#include "TargetEntity.h"
+
+AimAgent::AimAgent(const AimAgentConfig& config, uint32 seed) : m_config(config) {
+	m_rng = std::make_shared<Random>(seed, false);
+}
+
+Vector2 AimAgent::viewAngles(const Point3& eye, const Point3& point) {
+	// Inverse of the player view rotation (look vector is (sin(h)cos(t), sin(t), -cos(h)cos(t)))
+	const Vector3 dir = (point - eye).directionOrZero();
+	return Vector2(atan2(dir.x, -dir.z), asin(clamp(dir.y, -1.0f, 1.0f)));
+}
+
+float AimAgent::wrapAngle(float a) {
+	return a - 2.0f * pif() * floor((a + pif()) / (2.0f * pif()));
+}
+
+shared_ptr<TargetEntity> AimAgent::selectTarget(const Point3& eye, const Vector2& view, const Array<shared_ptr<TargetEntity>>& targets) const {
+	const Vector3 look(sin(view.x) * cos(view.y), sin(view.y), -cos(view.x) * cos(view.y));
+	shared_ptr<TargetEntity> best;
+	float bestDot = -finf();
+	for (const shared_ptr<TargetEntity>& target : targets) {
+		const float d = look.dot((target->frame().translation - eye).directionOrZero());
+		if (d > bestDot) {
+			bestDot = d;
+			best = target;
+		}
+	}
+	return best;
+}
+
+bool AimAgent::update(float dt, const shared_ptr<PlayerEntity>& player, const Array<shared_ptr<TargetEntity>>& targets, bool engage) {
+	if (isNull(player)) return false;
+	const Point3 eye = player->getCameraFrame().translation;
+	Vector2 view(player->heading(), player->headTilt());
+
+	// Drop the current target once it is destroyed (or reused under a new name)
+	if (notNull(m_target) && (!targets.contains(m_target) || m_target->name() != m_targetName)) {
+		m_target = nullptr;
+	}
+
+	if (!engage) {
+		m_target = nullptr;
+	}
+	else if (isNull(m_target)) {
+		m_target = selectTarget(eye, view, targets);
+		if (notNull(m_target)) {
+			m_targetName = m_target->name();
+			m_phase = Phase::Reacting;
+			m_phaseTime = 0.0f;
+		}
+	}
+
+	if (isNull(m_target)) {
+		m_phase = Phase::Idle;
+		m_trigger = false;
+		return m_trigger;
+	}
+
+	m_phaseTime += dt;
+	const Vector2 aim = viewAngles(eye, m_target->frame().translation);
+	const Vector2 error(wrapAngle(aim.x - view.x), aim.y - view.y);
+
+	switch (m_phase) {
+	case Phase::Reacting:
+		if (m_phaseTime >= m_config.reactionTime) {
+			if (m_config.model == "flick") {
+				m_flickStart = view;
+				m_flickEnd = view + error + Vector2(m_rng->gaussian(0.0f, m_config.flickError), m_rng->gaussian(0.0f, m_config.flickError)) * units::degrees();
+				m_phase = Phase::Flicking;
+			}
+			else {
+				m_phase = Phase::Tracking;
+			}
+			m_phaseTime = 0.0f;
+		}
+		break;
+
+	case Phase::Flicking: {
+		// Minimum jerk profile from the start to the end of the flick
+		const float s = min(m_phaseTime / max(m_config.flickDuration, 1e-6f), 1.0f);
+		const float p = s * s * s * (10.0f - 15.0f * s + 6.0f * s * s);
+		view = m_flickStart + (m_flickEnd - m_flickStart) * p;
+		if (s >= 1.0f) {
+			m_phase = Phase::Tracking;
+			m_phaseTime = 0.0f;
+		}
+		break;
+	}
+
+	case Phase::Tracking: {
+		// Proportional tracking w/ noise, limited to the max turn rate
+		const float maxStep = m_config.maxTurnRate * units::degrees() * dt;
+		for (int axis = 0; axis < 2; axis++) {
+			const float rate = m_config.trackingGain * error[axis] + m_rng->gaussian(0.0f, m_config.aimNoise) * units::degrees();
+			view[axis] += clamp(rate * dt, -maxStep, maxStep);
+		}
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	player->setView(view.x, view.y);
+
+	// Fire when on target (pulsing the trigger so non-auto fire weapons see a release between shots)
+	const Vector2 remaining(wrapAngle(aim.x - view.x) * cos(view.y), aim.y - view.y);
+	const bool onTarget = (m_phase == Phase::Tracking) && (remaining.length() < m_config.fireAngle * units::degrees());
+	m_trigger = onTarget && !m_trigger;
+	return m_trigger;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <G3D/G3D.h>
+#include "ConfigFiles.h"
+
+class PlayerEntity;
+class TargetEntity;
+
+/** Synthetic player that aims at (and shoots) the live targets, used to run sessions w/o a human in headless mode.
+	The agent turns the player the way mouse input would and reports the trigger state, the app turns this into
+	shoot key events so firing goes through the normal input handling (and logging). */
+class AimAgent : public ReferenceCountedObject {
+protected:
+	/** State of the current engagement */
+	enum class Phase {
+		Idle,			///< No target
+		Reacting,		///< Target selected, waiting out the reaction time
+		Flicking,		///< Flicking toward the target (flick model only)
+		Tracking		///< Tracking the target
+	};
+
+	AimAgentConfig			m_config;
+	shared_ptr<Random>		m_rng;								///< Random source for noise (seeded on creation)
+
+	shared_ptr<TargetEntity>	m_target;						///< Current target
+	String					m_targetName;						///< Name of the current target (targets are reused under new names)
+	Phase					m_phase = Phase::Idle;
+	float					m_phaseTime = 0.0f;					///< Time spent in the current phase (in seconds)
+
+	Vector2					m_flickStart;						///< View (heading, tilt) at the start of the flick (in radians)
+	Vector2					m_flickEnd;							///< View (heading, tilt) at the end of the flick (in radians)
+
+	bool					m_trigger = false;					///< Trigger state
+
+	AimAgent(const AimAgentConfig& config, uint32 seed);
+
+	/** View angles (heading, tilt) in radians to look from eye toward point */
+	static Vector2 viewAngles(const Point3& eye, const Point3& point);
+
+	/** Wrap an angle to [-pi, pi) */
+	static float wrapAngle(float a);
+
+	/** Select the target closest to the current view direction (or nullptr if there are no targets) */
+	shared_ptr<TargetEntity> selectTarget(const Point3& eye, const Vector2& view, const Array<shared_ptr<TargetEntity>>& targets) const;
+
+public:
+	static shared_ptr<AimAgent> create(const AimAgentConfig& config, uint32 seed) {
+		return createShared<AimAgent>(config, seed);
+	}
+
+	/** Update the agent by dt, turning the player toward the current target.
+		Targets are only engaged when engage is set (i.e. during the task), otherwise the agent idles w/ the trigger released.
+		Returns the trigger state (pressed or not) for this step. */
+	bool update(float dt, const shared_ptr<PlayerEntity>& player, const Array<shared_ptr<TargetEntity>>& targets, bool engage);
+};
@@ -6,6 +6,7 @@
 #include "Session.h"
 #include "PhysicsScene.h"
 #include "WaypointManager.h"
+#include "CollisionCache.h"
 #include <chrono>
 
 // Scale and offset for target
@@ -25,35 +26,98 @@ App::App(const GApp::Settings& settings) : GApp(settings) {}
 
 /** Initialize the app */
 void App::onInit() {
-	// Seed random based on the time
-	Random::common().reset(uint32(time(0)));
+	if (startupConfig.headless) {
+		// Seed random from the config and switch to the simulated clock so runs are repeatable
+		Random::common().reset(uint32(startupConfig.headlessRandomSeed));
+		SimClock::setSimulated(true);
+		m_headless = HeadlessDriver::create(startupConfig.headlessTimeStep, startupConfig.headlessDuration, startupConfig.headlessInputScript);
+		if (startupConfig.aimAgent.enable) {
+			m_aimAgent = AimAgent::create(startupConfig.aimAgent, Random::common().bits());
+		}
+	}
+	else {
+		// Seed random based on the time
+		Random::common().reset(uint32(time(0)));
+	}
 
 	// Initialize the app
 	GApp::onInit();
 
-	// Load experiment setting from file
-	experimentConfig = ExperimentConfig::load(startupConfig.experimentConfig());
-	experimentConfig.printToLog();
+	// Create the job pool used for target updates
+	m_jobPool = JobPool::create();
+	TraceRecorder::setThreadName("Main");
+
+	// Resolve the startup files up front (System::findDataFile() caches its lookups and isn't thread safe), worker tasks only get resolved paths.
+	// Configs that don't exist yet are loaded on the main thread, where load() writes the default file.
+	const String experimentFile = System::findDataFile(startupConfig.experimentConfig(), false);
+	const String userFile = System::findDataFile(startupConfig.userConfig(), false);
+	const String userStatusFile = FileSystem::exists("userstatus.Any") ? System::findDataFile("userstatus.Any", false) : "";
+	const String keyMapFile = System::findDataFile("keymap.Any", false);
+	const auto configAffinity = [](const String& file) {
+		return (!file.empty() && FileSystem::exists(file)) ? TaskGraph::Affinity::Worker : TaskGraph::Affinity::Main;
+	};
+	const String decalFile = System::findDataFile("bullet-decal-256x256.png");
+	const String explosionFile = System::findDataFile("explosion_01.png");
+	for (const String& file : { String("systemconfig.Any"), String("arial.fnt"), String("gui/hud.png") }) {
+		System::findDataFile(file, false);
+	}
+	Array<String> reticleFiles;
+	for (int i = 0; i < numReticles; i++) {
+		reticleFiles.append(System::findDataFile(format("gui/reticle/reticle-%03d.png", i)));
+	}
+	// This special case is added to allow a custom reticle not in the gui/reticle/reticle-[x].png format
+	reticleFiles.append(System::findDataFile("gui/reticle.png"));
+	reticleAtlas = ReticleAtlas::create();
+
+	// Load the configs and assets, config parsing and file reads run on the job pool while the main thread creates GPU resources
+	TaskGraph startup;
+	const TaskGraph::Affinity experimentAffinity = configAffinity(experimentFile);
+	startup.add("experimentConfig", experimentAffinity, [=]() {
+		experimentConfig = (experimentAffinity == TaskGraph::Affinity::Worker) ? ExperimentConfig(Any::fromFile(experimentFile)) : ExperimentConfig::load(startupConfig.experimentConfig());
+	});
+	const TaskGraph::Affinity userAffinity = configAffinity(userFile);
+	startup.add("userTable", userAffinity, [=]() {
+		userTable = (userAffinity == TaskGraph::Affinity::Worker) ? UserTable(Any::fromFile(userFile)) : UserTable::load(startupConfig.userConfig());
+	});
+	const TaskGraph::Affinity userStatusAffinity = configAffinity(userStatusFile);
+	startup.add("userStatusTable", userStatusAffinity, [=]() {
+		userStatusTable = (userStatusAffinity == TaskGraph::Affinity::Worker) ? UserStatusTable(Any::fromFile(userStatusFile)) : UserStatusTable::load();
+	});
+	const TaskGraph::Affinity keyMapAffinity = configAffinity(keyMapFile);
+	startup.add("keyMap", keyMapAffinity, [=]() {
+		keyMap = (keyMapAffinity == TaskGraph::Affinity::Worker) ? KeyMapping(Any::fromFile(keyMapFile)) : KeyMapping::load();
+	});
+	startup.add("systemConfig", TaskGraph::Affinity::Main, [this]() { m_sysConfig = SystemConfig::load(); });		// Queries the GPU name (needs the GL context)
+	startup.add("fonts", TaskGraph::Affinity::Main, [this]() {
+		outputFont = GFont::fromFile(System::findDataFile("arial.fnt"));
+		hudTexture = Texture::fromFile(System::findDataFile("gui/hud.png"));
+	});
+	startup.add("reticleImages", TaskGraph::Affinity::Worker, [&]() { reticleAtlas->pack(reticleFiles); });
+	startup.add("reticleAtlas", TaskGraph::Affinity::Main, [this]() { reticleAtlas->upload(); }, { "reticleImages" });
+	startup.add("modelImages", TaskGraph::Affinity::Worker, [=]() { decodeModelImages(decalFile, explosionFile); });
+	startup.add("modelTextures", TaskGraph::Affinity::Main, [this]() { uploadModelTextures(); }, { "modelImages" });
+	startup.add("weaponModels", TaskGraph::Affinity::Main, [this]() { loadWeaponModels(); }, { "experimentConfig", "modelTextures" });
+	startup.add("targetModelFiles", TaskGraph::Affinity::Main, [this]() { resolveTargetModels(); }, { "experimentConfig" });
+	startup.add("targetModelSpecs", TaskGraph::Affinity::Worker, [this]() { prepareTargetModels(); }, { "targetModelFiles" });
+	startup.add("targetModels", TaskGraph::Affinity::Main, [this]() { loadTargetModels(); }, { "targetModelSpecs" });
+	startup.run(m_jobPool);
+	startup.logTimings("Startup");
 
+	experimentConfig.printToLog();
 	Array<String> sessionIds;
 	experimentConfig.getSessionIds(sessionIds);
 
-	// Load per user settings from file
-	userTable = UserTable::load(startupConfig.userConfig());
 	userTable.printToLog();
 
-	// Load per experiment user settings from file and make sure they are valid
-	userStatusTable = UserStatusTable::load();
+	// Make sure the per experiment user settings are valid
 	userStatusTable.printToLog();
 	userStatusTable.validate(sessionIds);
 	
-	// Get and save system configuration
-	SystemConfig sysConfig = SystemConfig::load();
-	sysConfig.printToLog();											// Print system info to log.txt
-	sysConfig.toAny().save("systemconfig.Any");						// Update the any file here (new system info to write)
+	// Save system configuration
+	m_sysConfig.printToLog();										// Print system info to log.txt
+	m_sysConfig.toAny().save("systemconfig.Any");					// Update the any file here (new system info to write)
 
-	// Load the key binds
-	keyMap = KeyMapping::load();
+	// Apply the key binds
 	userInput->setKeyMapping(&keyMap.uiMap);
 
 	// Setup/update waypoint manager
@@ -68,6 +132,7 @@ void App::onInit() {
 
 	// Setup the scene
 	setScene(PhysicsScene::create(m_ambientOcclusion));
+	typedScene<PhysicsScene>()->setCollisionCachePath(startupConfig.collisionCachePath);
 	scene()->registerEntitySubclass("PlayerEntity", &PlayerEntity::create);			// Register the player entity for creation
 	scene()->registerEntitySubclass("FlyingEntity", &FlyingEntity::create);			// Create a target
 
@@ -75,12 +140,7 @@ void App::onInit() {
 	showRenderingStats = false;
 	makeGUI();
 	   
-	// Load fonts and images
-	outputFont = GFont::fromFile(System::findDataFile("arial.fnt"));
-	hudTexture = Texture::fromFile(System::findDataFile("gui/hud.png"));
-
-	// Load models and set the reticle
-	loadModels();
+	// Set the reticle
 	setReticle(userTable.getCurrentUser()->reticleIndex);
 
 	updateMouseSensitivity();			// Update (apply) mouse sensitivity
@@ -223,20 +283,12 @@ void App::spawnRandomTarget() {
 
 /** Spawn a flying entity target */
 shared_ptr<FlyingEntity> App::spawnTarget(const Point3& position, float scale, bool spinLeft, const Color3& color, String modelName) {
-	const int scaleIndex = clamp(iRound(log(scale) / log(1.0f + TARGET_MODEL_ARRAY_SCALING) + TARGET_MODEL_ARRAY_OFFSET), 0, m_modelScaleCount - 1);
-
-	const shared_ptr<FlyingEntity>& target = FlyingEntity::create(format("target%03d", ++m_lastUniqueID), scene().get(), m_targetModels[modelName][scaleIndex], CFrame());
-
-	UniversalMaterial::Specification materialSpecification;
-	materialSpecification.setLambertian(Texture::Specification(color));
-	materialSpecification.setEmissive(Texture::Specification(color * 0.7f));
-	materialSpecification.setGlossy(Texture::Specification(Color4(0.4f, 0.2f, 0.1f, 0.8f)));
+	const int scaleIndex = modelScaleIndex(scale);
 
-	const shared_ptr<ArticulatedModel::Pose>& amPose = ArticulatedModel::Pose::create();
-	amPose->materialTable.set("core/icosahedron_default", UniversalMaterial::create(materialSpecification));
-	target->setPose(amPose);
+	const shared_ptr<FlyingEntity>& target = FlyingEntity::create(format("target%03d", ++m_lastUniqueID), scene().get(), targetModel(modelName, scaleIndex), CFrame());
+	setTargetMaterial(target, color);
 
-	target->setFrame(position);
+	target->teleport(position);
 	/*
 	// Don't set a track. We'll take care of the positioning after creation
 	String animation = format("combine(orbit(0, %d), CFrame::fromXYZYPRDegrees(%f, %f, %f))", spinLeft ? 1 : -1, position.x, position.y, position.z);
@@ -246,6 +298,7 @@ shared_ptr<FlyingEntity> App::spawnTarget(const Point3& position, float scale, b
 
 	target->setShouldBeSaved(false);
 	targetArray.append(target);
+	m_targetBVHDirty = true;
 	scene()->insert(target);
 	return target;
 }
@@ -254,25 +307,18 @@ shared_ptr<TargetEntity> App::spawnDestTarget(const Point3 position, Array<Desti
 	 String id, int paramIdx, int respawns, String name, bool isLogged) {	
 	// Create the target
 	String nameStr = name.empty() ? format("target%03d", ++m_lastUniqueID) : name;
-	const int scaleIndex = clamp(iRound(log(scale) / log(1.0f + TARGET_MODEL_ARRAY_SCALING) + TARGET_MODEL_ARRAY_OFFSET), 0, m_modelScaleCount - 1);
-	const shared_ptr<TargetEntity>& target = TargetEntity::create(dests, nameStr, scene().get(), m_targetModels[id][scaleIndex], scaleIndex, CFrame(), paramIdx, position, respawns, isLogged);
-
-	// Setup the texture
-	UniversalMaterial::Specification materialSpecification;
-	materialSpecification.setLambertian(Texture::Specification(color));
-	materialSpecification.setEmissive(Texture::Specification(color * 0.7f));
-	materialSpecification.setGlossy(Texture::Specification(Color4(0.4f, 0.2f, 0.1f, 0.8f)));
-	
-	const shared_ptr<ArticulatedModel::Pose>& amPose = ArticulatedModel::Pose::create();
-	amPose->materialTable.set("core/icosahedron_default", UniversalMaterial::create(materialSpecification));
+	const int scaleIndex = modelScaleIndex(scale);
+	const shared_ptr<TargetEntity>& pooled = m_targetPool.takeDestTarget();
+	const shared_ptr<TargetEntity>& target = TargetEntity::create(dests, nameStr, scene().get(), targetModel(id, scaleIndex), scaleIndex, CFrame(), paramIdx, position, respawns, isLogged, pooled);
 
 	// Apply texture/position to target
-	target->setPose(amPose);
-	target->setFrame(position);
+	setTargetMaterial(target, color);
+	target->teleport(position);
 	target->setShouldBeSaved(false);
 
 	// Add target to array and scene
 	targetArray.append(target);
+	m_targetBVHDirty = true;
 	scene()->insert(target);
 
 	return target;
@@ -293,12 +339,13 @@ shared_ptr<FlyingEntity> App::spawnFlyingTarget(
 	String name,
 	bool isLogged)
 {
-	const int scaleIndex = clamp(iRound(log(scale) / log(1.0f + TARGET_MODEL_ARRAY_SCALING) + TARGET_MODEL_ARRAY_OFFSET), 0, m_modelScaleCount - 1);
+	const int scaleIndex = modelScaleIndex(scale);
 	String nameStr = name.empty() ? format("target%03d", ++m_lastUniqueID) : name;
+	const shared_ptr<FlyingEntity>& pooled = m_targetPool.takeFlyingTarget();
 	const shared_ptr<FlyingEntity>& target = FlyingEntity::create(
 		nameStr,
 		scene().get(),
-		m_targetModels[id][scaleIndex],
+		targetModel(id, scaleIndex),
 		scaleIndex,
 		CFrame(),
 		speedRange,
@@ -308,22 +355,17 @@ shared_ptr<FlyingEntity> App::spawnFlyingTarget(
 		paramIdx,
 		axisLock,
 		respawns,
-		isLogged
+		isLogged,
+		pooled
 	);
 
-	UniversalMaterial::Specification materialSpecification;
-	materialSpecification.setLambertian(Texture::Specification(color));
-	materialSpecification.setEmissive(Texture::Specification(color * 0.7f));
-	materialSpecification.setGlossy(Texture::Specification(Color4(0.4f, 0.2f, 0.1f, 0.8f)));
-
-	const shared_ptr<ArticulatedModel::Pose>& amPose = ArticulatedModel::Pose::create();
-	amPose->materialTable.set("core/icosahedron_default", UniversalMaterial::create(materialSpecification));
-	target->setPose(amPose);
+	setTargetMaterial(target, color);
 
-	target->setFrame(position);
+	target->teleport(position);
 
 	target->setShouldBeSaved(false);
 	targetArray.append(target);
+	m_targetBVHDirty = true;
 	scene()->insert(target);
 	return target;
 }
@@ -347,12 +389,13 @@ shared_ptr<JumpingEntity> App::spawnJumpingTarget(
 	String name,
 	bool isLogged)
 {
-	const int scaleIndex = clamp(iRound(log(scale) / log(1.0f + TARGET_MODEL_ARRAY_SCALING) + TARGET_MODEL_ARRAY_OFFSET), 0, m_modelScaleCount - 1);
+	const int scaleIndex = modelScaleIndex(scale);
 	String nameStr = name.empty() ? format("target%03d", ++m_lastUniqueID) : name;
+	const shared_ptr<JumpingEntity>& pooled = m_targetPool.takeJumpingTarget();
 	const shared_ptr<JumpingEntity>& target = JumpingEntity::create(
 		nameStr,
 		scene().get(),
-		m_targetModels[id][scaleIndex],
+		targetModel(id, scaleIndex),
 		scaleIndex,
 		CFrame(),
 		speedRange,
@@ -366,27 +409,47 @@ shared_ptr<JumpingEntity> App::spawnJumpingTarget(
 		paramIdx,
 		axisLock,
 		respawns,
-		isLogged
+		isLogged,
+		pooled
 	);
 
-	UniversalMaterial::Specification materialSpecification;
-	materialSpecification.setLambertian(Texture::Specification(color));
-	materialSpecification.setEmissive(Texture::Specification(color * 0.7f));
-	materialSpecification.setGlossy(Texture::Specification(Color4(0.4f, 0.2f, 0.1f, 0.8f)));
-
-	const shared_ptr<ArticulatedModel::Pose>& amPose = ArticulatedModel::Pose::create();
-	amPose->materialTable.set("core/icosahedron_default", UniversalMaterial::create(materialSpecification));
-	target->setPose(amPose);
+	setTargetMaterial(target, color);
 
-	target->setFrame(position);
+	target->teleport(position);
 
 	target->setShouldBeSaved(false);
 	targetArray.append(target);
+	m_targetBVHDirty = true;
 	scene()->insert(target);
 	return target;
 }
 
-void App::loadModels() {
+void App::setTargetMaterial(const shared_ptr<TargetEntity>& target, const Color3& color) {
+	target->setPose(m_targetPoses->pose(color));
+}
+
+void App::decodeModelImages(const String& decalFile, const String& explosionFile) {
+	m_decalImage = Image::fromFile(decalFile);
+	m_explosionImage = Image::fromFile(explosionFile);
+}
+
+void App::uploadModelTextures() {
+	m_decalTexture = Texture::fromImage("bullet-decal-256x256.png", m_decalImage);
+	m_explosionTexture = Texture::fromImage("explosion_01.png", m_explosionImage);
+	m_decalImage = nullptr;
+	m_explosionImage = nullptr;
+}
+
+void App::setModelTexture(const shared_ptr<ArticulatedModel>& model, const shared_ptr<Texture>& texture) {
+	UniversalMaterial::Specification spec;
+	spec.setLambertian(texture);
+	const shared_ptr<UniversalMaterial>& material = UniversalMaterial::create(spec);
+	for (ArticulatedModel::Mesh* mesh : model->meshArray()) {
+		mesh->material = material;
+	}
+}
+
+void App::loadWeaponModels() {
 	if ((experimentConfig.weapon.renderModel || startupConfig.developerMode) && !experimentConfig.weapon.modelSpec.filename.empty()) {
 		// Load the model if we (might) need it
 		m_viewModel = ArticulatedModel::create(experimentConfig.weapon.modelSpec, "viewModel");
@@ -405,20 +468,18 @@ void App::loadModels() {
 
 	m_bulletModel = ArticulatedModel::create(bulletSpec, "bulletModel");
 
+	// The decal texture was decoded on a worker (see decodeModelImages())
 	const static Any decalSpec = PARSE_ANY(ArticulatedModel::Specification{
 		filename = "ifs/square.ifs";
 		preprocess = {
 			transformGeometry(all(), Matrix4::scale(0.1, 0.1, 0.1));
-			setMaterial(all(), UniversalMaterial::Specification{
-				lambertian = Texture::Specification {
-					filename = "bullet-decal-256x256.png";
-					encoding = Color3(1, 1, 1);
-				};
-			});
 		}; });
 
 	m_decalModel = ArticulatedModel::create(decalSpec, "decalModel");
+	setModelTexture(m_decalModel, m_decalTexture);
+}
 
+void App::resolveTargetModels() {
 	// Add all the unqiue targets to this list
 	Table<String, Any> toBuild;
 	for (TargetConfig target : experimentConfig.targets) {
@@ -439,57 +500,159 @@ void App::loadModels() {
 		scale = 0.25;
 	}));
 
-	// Setup the explosion specification
-	Any explosionSpec = PARSE_ANY(ArticulatedModel::Specification{
+	// Setup the explosion specification (scaled models are created on first use, w/ the texture decoded by decodeModelImages())
+	m_explosionSpec = PARSE_ANY(ArticulatedModel::Specification{
 		filename = "ifs/square.ifs";
 		preprocess = {
 			transformGeometry(all(), Matrix4::scale(0.1, 0.1, 0.1));
 			//scaleAndOffsetTexCoord0(all(), 0.0769, 0);
-			setMaterial(all(), UniversalMaterial::Specification{
-				lambertian = Texture::Specification {
-					//filename = "explosion_01_strip13.png";
-					filename = "explosion_01.png";
-					encoding = Color3(1, 1, 1);
-				};
-			});
 		}; 
 	});
-	for (int i = 0; i < m_modelScaleCount; i++) {
-		const float scale = pow(1.0f + TARGET_MODEL_ARRAY_SCALING, float(i) - TARGET_MODEL_ARRAY_OFFSET);
-		explosionSpec.set("scale", scale*20.0f);
-		m_explosionModels.push(ArticulatedModel::create(explosionSpec));
-	}
+	m_explosionModels.fastClear();
+	m_explosionModels.resize(m_modelScaleCount);
 
-	// Scale the models into the m_targetModel table
+	// List the target models w/ their resolved files, prepareTargetModels() sizes them from the bounds cache
+	m_unsizedTargetModels.fastClear();
 	for (String id : toBuild.getKeys()) {
-		// Get the any spec
-		Any spec = toBuild.get(id);
-		// Get the bounding box to scale to size rather than arbitrary factor
-		shared_ptr<ArticulatedModel> size_model = ArticulatedModel::create(ArticulatedModel::Specification(spec));
+		UnsizedTargetModel unsized;
+		unsized.id = id;
+		unsized.spec = toBuild.get(id);
+		unsized.file = System::findDataFile(ArticulatedModel::Specification(unsized.spec).filename, false);
+		m_unsizedTargetModels.append(unsized);
+	}
+	m_boundsCacheExists = FileSystem::exists(m_boundsCacheFile);
+}
+
+void App::prepareTargetModels() {
+	// Load the cached model bounding boxes (keyed by model specification hash, checked against the model file stamp), so we only load a model to size it once
+	Any loaded(Any::TABLE);
+	if (m_boundsCacheExists) {
+		try {
+			loaded.load(m_boundsCacheFile);
+		}
+		catch (...) {
+			logPrintf("Could not read bounding box cache \"%s\", rebuilding it\n", m_boundsCacheFile.c_str());
+		}
+		if (loaded.type() != Any::TABLE) {
+			loaded = Any(Any::TABLE);		// Old (array) format, rebuild it
+		}
+	}
+	// Only entries for the current specs are kept (so the cache doesn't grow w/ every spec ever used)
+	m_boundsCache = Any(Any::TABLE);
+
+	// Setup the per-id (unscaled) specifications for the m_targetModels table, models missing from the bounds cache are sized by loadTargetModels()
+	m_targetModelSpecs.clear();
+	m_targetModels.clear();
+	const Array<UnsizedTargetModel> models = m_unsizedTargetModels;
+	m_unsizedTargetModels.fastClear();
+	for (UnsizedTargetModel unsized : models) {
+		const String& id = unsized.id;
+		const Any& spec = unsized.spec;
+		const String specString = spec.unparse();
+		const String stamp = format("%016llx", (unsigned long long)CollisionCache::fileStamp(unsized.file));
+		const String key = format("spec%016llx", (unsigned long long)CollisionCache::stringHash(specString));
+
+		// Get the bounding box to scale to size rather than arbitrary factor (entries for an edited model file are rebuilt)
+		Vector3 extent = Vector3::nan();
+		if (loaded.containsKey(key)) {
+			const Any& entry = loaded[key];
+			if (entry["spec"].unparse() == specString && entry.containsKey("stamp") && String(entry["stamp"]) == stamp) {
+				extent = Vector3(entry["extent"]);
+				m_boundsCache.set(key, entry);
+			}
+		}
+		if (extent.isNaN()) {
+			// Creating the model to size it needs the GL context (for its materials)
+			unsized.stamp = stamp;
+			unsized.cacheKey = key;
+			m_unsizedTargetModels.append(unsized);
+		}
+		else {
+			setTargetModelExtent(id, spec, extent);
+		}
+	}
+	m_boundsCacheChanged = (m_boundsCache.size() != loaded.size());
+}
+
+void App::setTargetModelExtent(const String& id, Any spec, const Vector3& extent) {
+	logPrintf("%20s bounding box: [%2.2f, %2.2f, %2.2f]\n", id.c_str(), extent[0], extent[1], extent[2]);
+	float default_scale = 1.0f / extent[0];					// Setup scale so that default model is 1m across
+
+	spec.set("scale", default_scale);
+	m_targetModelSpecs.set(id, spec);
+	Array<shared_ptr<ArticulatedModel>> models;
+	models.resize(m_modelScaleCount);
+	m_targetModels.set(id, models);
+}
+
+void App::loadTargetModels() {
+	// Size the models missing from the bounds cache (and add them to it)
+	for (const UnsizedTargetModel& unsized : m_unsizedTargetModels) {
+		shared_ptr<ArticulatedModel> size_model = ArticulatedModel::create(ArticulatedModel::Specification(unsized.spec));
 		AABox bbox;
 		size_model->getBoundingBox(bbox);
-		Vector3 extent = bbox.extent();
-		logPrintf("%20s bounding box: [%2.2f, %2.2f, %2.2f]\n", id.c_str(), extent[0], extent[1], extent[2]);
-		float default_scale = 1.0f / extent[0];					// Setup scale so that default model is 1m across
+		const Vector3 extent = bbox.extent();
+		Any entry(Any::TABLE);
+		entry["spec"] = unsized.spec;
+		entry["extent"] = extent;
+		entry["stamp"] = unsized.stamp;
+		m_boundsCache.set(unsized.cacheKey, entry);
+		setTargetModelExtent(unsized.id, unsized.spec, extent);
+	}
+	if (m_unsizedTargetModels.size() > 0 || m_boundsCacheChanged) {
+		m_boundsCache.save(m_boundsCacheFile);
+	}
+	m_unsizedTargetModels.fastClear();
+	m_boundsCache = Any();
 
-		Array<shared_ptr<ArticulatedModel>> models;
-		for (int i = 0; i <= m_modelScaleCount; ++i) {
-			const float scale = pow(1.0f + TARGET_MODEL_ARRAY_SCALING, float(i) - TARGET_MODEL_ARRAY_OFFSET);
-			spec.set("scale", scale*default_scale);
-			models.push(ArticulatedModel::create(spec));
-		}
-		m_targetModels.set(id, models);
+	// Create a series of colored poses to choose from for target health
+	m_targetPoses = TargetPoseCache::create();
+	m_targetPoses->setHealthColors(experimentConfig.targetView.healthColors, m_MatTableSize);
+}
+
+int App::modelScaleIndex(float scale) const {
+	return clamp(iRound(log(scale) / log(1.0f + TARGET_MODEL_ARRAY_SCALING) + TARGET_MODEL_ARRAY_OFFSET), 0, m_modelScaleCount - 1);
+}
+
+const shared_ptr<ArticulatedModel>& App::targetModel(const String& id, int scaleIdx) {
+	shared_ptr<ArticulatedModel>& model = m_targetModels[id][scaleIdx];
+	if (isNull(model)) {
+		Any spec = m_targetModelSpecs[id];
+		const float scale = pow(1.0f + TARGET_MODEL_ARRAY_SCALING, float(scaleIdx) - TARGET_MODEL_ARRAY_OFFSET);
+		spec.set("scale", scale * float(spec["scale"].number()));
+		model = ArticulatedModel::create(spec);
 	}
+	return model;
+}
 
-	// Create a series of colored materials to choose from for target health
-	for (int i = 0; i < m_MatTableSize; i++) {
-		float complete = (float)i / m_MatTableSize;
-		Color3 color = experimentConfig.targetView.healthColors[0] * complete + experimentConfig.targetView.healthColors[1] * (1.0f - complete);
-		UniversalMaterial::Specification materialSpecification;
-		materialSpecification.setLambertian(Texture::Specification(color));
-		materialSpecification.setEmissive(Texture::Specification(color * 0.7f));
-		materialSpecification.setGlossy(Texture::Specification(Color4(0.4f, 0.2f, 0.1f, 0.8f)));
-		m_materials.append(UniversalMaterial::create(materialSpecification));
+const shared_ptr<ArticulatedModel>& App::explosionModel(int scaleIdx) {
+	shared_ptr<ArticulatedModel>& model = m_explosionModels[scaleIdx];
+	if (isNull(model)) {
+		Any spec = m_explosionSpec;
+		const float scale = pow(1.0f + TARGET_MODEL_ARRAY_SCALING, float(scaleIdx) - TARGET_MODEL_ARRAY_OFFSET);
+		spec.set("scale", scale*20.0f);
+		model = ArticulatedModel::create(spec);
+		setModelTexture(model, m_explosionTexture);
+	}
+	return model;
+}
+
+void App::prepareSessionModels() {
+	// Reference target (and its explosion)
+	const int refIdx = modelScaleIndex(sessConfig->targetView.refTargetSize);
+	targetModel("reference", refIdx);
+	explosionModel(refIdx);
+
+	// Create every scale the session's targets can be drawn at, so models aren't loaded mid-trial
+	for (const TrialCount& trial : sessConfig->trials) {
+		for (const String& id : trial.ids) {
+			const shared_ptr<TargetConfig>& target = experimentConfig.getTargetConfigById(id);
+			if (isNull(target) || !m_targetModelSpecs.containsKey(id)) continue;
+			for (int i = modelScaleIndex(target->size[0]); i <= modelScaleIndex(target->size[1]); i++) {
+				targetModel(id, i);
+				explosionModel(i);
+			}
+		}
 	}
 }
 
@@ -531,6 +694,7 @@ void App::makeGUI() {
 		debugPane->addButton("Player Controls [2]", this, &App::showPlayerControls);
 		debugPane->addButton("Weapon Controls [3]", this, &App::showWeaponControls);
 		if(startupConfig.waypointEditorMode) debugPane->addButton("Waypoint Manager [4]", waypointManager, &WaypointManager::showWaypointWindow);
+		debugPane->addButton("Collision Benchmark", this, &App::runCollisionBenchmark);
 	}debugPane->endRow();
 
     // set up user settings window
@@ -579,6 +743,30 @@ void App::showWeaponControls() {
 	m_weaponControls->setVisible(true);
 }
 
+void App::updatePrefetch() {
+	// Prefetch once the last trial's feedback is showing, through the scoreboard and user settings menu
+	const PresentationState state = sess->presentationState;
+	const bool lastFeedback = (state == PresentationState::feedback) && sess->isComplete();
+	if (!lastFeedback && state != PresentationState::scoreboard && state != PresentationState::complete) return;
+
+	if (isNull(m_prefetch)) {
+		// The session isn't marked complete until its feedback is done, skip over it until then
+		const String next = userStatusTable.getNextSession(userTable.currentUser, lastFeedback ? sessConfig->id : "");
+		const shared_ptr<SessionConfig>& config = next.empty() ? nullptr : experimentConfig.getSessionConfigById(next);
+		if (isNull(config)) return;
+		m_prefetch = SessionPrefetcher::create(config, m_loadedScene, startupConfig.collisionCachePath, m_fontCache, m_soundCache);
+	}
+	m_prefetch->update();
+}
+
+void App::runCollisionBenchmark() {
+	const shared_ptr<PlayerEntity>& player = scene()->typedEntity<PlayerEntity>("player");
+	if (isNull(player)) return;
+	// Sample moves around the player (within 20m horizontally)
+	const String result = CollisionTriangles::benchmark(typedScene<PhysicsScene>().get(), player->frame().translation, 20.0f, player->collisionProxy().radius, 2000);
+	logPrintf("%s (scene: %s)\n", result.c_str(), m_loadedScene.c_str());
+}
+
 void App::userSaveButtonPress(void) {
 	// Save the any file
 	Any a = Any(userTable);
@@ -719,6 +907,10 @@ void App::updateSession(const String& id) {
 	// Check for a valid ID (non-emtpy and 
 	Array<String> ids;
 	experimentConfig.getSessionIds(ids);
+	// The simulation thread's player copy points into the current session config, take it off the thread before replacing the config
+	if (notNull(m_simThread)) {
+		m_simThread->syncPlayer(nullptr, 0);
+	}
 	if (!id.empty() && ids.contains(id)) {
 		sessConfig = experimentConfig.getSessionConfigById(id);						// Get the new session config
 		logPrintf("User selected session: %s. Updating now...\n", id);				// Print message to log
@@ -736,9 +928,36 @@ void App::updateSession(const String& id) {
 	// Update the frame rate/delay
 	updateParameters(sessConfig->render.frameDelay, sessConfig->render.frameRate);
 
+	// Set the frame pacing mode (and start a new wake-up error histogram for this session)
+	m_framePacer.setMode(FramePacer::modeFromString(sessConfig->render.pacingMode), sessConfig->render.pacingSpinMarginMs / 1000.0);
+	m_framePacer.clearWakeErrors();
+	m_sessionFrameStats.clear();
+	m_frameScheduler.configure(sessConfig->render.jitPercentile, sessConfig->render.jitMarginMs / 1000.0);
+
+	// Use the prefetched assets if they are for this session (otherwise load them now)
+	SessionAssets assets;
+	if (notNull(m_prefetch) && m_prefetch->sessionId() == sessConfig->id) {
+		assets = m_prefetch->takeAssets();
+		uint64 sceneKey;
+		const shared_ptr<TriTree>& tree = m_prefetch->collisionTree(sceneKey);
+		if (notNull(tree)) {
+			typedScene<PhysicsScene>()->addCollisionTree(sceneKey, tree);
+		}
+	}
+	else {
+		assets.hudFont = m_fontCache.get(sessConfig->hud.hudFont);
+		assets.combatFont = m_fontCache.get(sessConfig->targetView.combatTextFont);
+		assets.fireSound = m_soundCache.get(sessConfig->weapon.fireSound);
+		assets.explosionSound = m_soundCache.get(sessConfig->audio.explosionSound);
+		if (sessConfig->weapon.renderModel) {
+			assets.viewModel = ArticulatedModel::create(sessConfig->weapon.modelSpec, "viewModel");
+		}
+	}
+	m_prefetch = nullptr;
+
 	// Load (session dependent) fonts
-	hudFont = GFont::fromFile(System::findDataFile(sessConfig->hud.hudFont));
-	m_combatFont = GFont::fromFile(System::findDataFile(sessConfig->targetView.combatTextFont));
+	hudFont = assets.hudFont;
+	m_combatFont = assets.combatFont;
 
 	// Handle clearing the targets here (clear any remaining targets before loading a new scene)
 	if (notNull(scene())) clearTargets();
@@ -757,27 +976,36 @@ void App::updateSession(const String& id) {
 	}
 
 	// Check for play mode specific parameters
-	m_fireSound = Sound::create(System::findDataFile(sessConfig->weapon.fireSound));
-	m_explosionSound = Sound::create(System::findDataFile(sessConfig->audio.explosionSound));
+	m_fireSound = assets.fireSound;
+	m_explosionSound = assets.explosionSound;
+
+	// Release (the least recently used) fonts and sounds no longer used by this session
+	m_fontCache.prune();
+	m_soundCache.prune();
 
 	// Update weapon model (if drawn)
 	if (sessConfig->weapon.renderModel) {
-		m_viewModel = ArticulatedModel::create(sessConfig->weapon.modelSpec, "viewModel");
+		m_viewModel = assets.viewModel;
 	}
 
-	// Create a series of colored materials to choose from for target health
-	for (int i = 0; i < m_MatTableSize; i++) {
-		float complete = (float)i / m_MatTableSize;
-		Color3 color = sessConfig->targetView.healthColors[0] * complete + sessConfig->targetView.healthColors[1] * (1.0f - complete);
-		UniversalMaterial::Specification materialSpecification;
-		materialSpecification.setLambertian(Texture::Specification(color));
-		materialSpecification.setEmissive(Texture::Specification(color * 0.7f));
-		materialSpecification.setGlossy(Texture::Specification(Color4(0.4f, 0.2f, 0.1f, 0.8f)));
-		m_materials.append(UniversalMaterial::create(materialSpecification));
+	// Update the colored poses used for target health (replaces the previous session's levels)
+	m_targetPoses->setHealthColors(sessConfig->targetView.healthColors, m_MatTableSize);
+
+	// Create the scaled target models this session uses
+	prepareSessionModels();
+
+	// Start/stop the simulation thread (not used in headless mode, where there is no real time to keep up with)
+	const bool useSimThread = sessConfig->timing.simulationThread && isNull(m_headless);
+	shared_ptr<PlayerEntity> player = scene()->typedEntity<PlayerEntity>("player");
+	if (!useSimThread || (notNull(m_simThread) && m_simThread->timeStep() != 1.0 / sessConfig->timing.simulationThreadRate)) {
+		m_simThread = nullptr;
+		player->setExternalMotion(false);
+	}
+	if (useSimThread && isNull(m_simThread)) {
+		m_simThread = SimulationThread::create(sessConfig->timing.simulationThreadRate);
 	}
 
 	// Player parameters
-	shared_ptr<PlayerEntity> player = scene()->typedEntity<PlayerEntity>("player");
 	sess->initialHeadingRadians = player->heading();
 	UserConfig *user = userTable.getCurrentUser();
 	// Copied from old FPM code
@@ -795,7 +1023,7 @@ void App::updateSession(const String& id) {
 	player->crouchHeight =	&sessConfig->player.crouchHeight;
 
 	// Check for need to start latency logging and if so run the logger now
-	SystemConfig sysConfig = SystemConfig::load();
+	const SystemConfig& sysConfig = m_sysConfig;
 	String logName = "../results/" + id + "_" + userTable.currentUser + "_" + String(Logger::genFileTimestamp());
 	if (sysConfig.hasLogger) {
 		if (!sessConfig->clickToPhoton.enabled) {
@@ -859,6 +1087,7 @@ void App::onAfterLoadScene(const Any& any, const String& sceneName) {
 	player->setVisible(false);
 	player->setRespawnHeight(resetHeight);
 	player->setRespawnPosition(player->frame().translation);
+	player->setScratchMemory(m_frameArena);
 	activeCamera()->setFieldOfView(FoV * units::degrees(), FOVDirection::HORIZONTAL);
 }
 
@@ -929,8 +1158,24 @@ void App::onSimulation(RealTime rdt, SimTime sdt, SimTime idt) {
 
 	// These are all we need from GApp::onSimulation() for walk mode
 	m_widgetManager->onSimulation(rdt, sdt, idt);
-	if (scene()) { scene()->onSimulation(sdt); }
-	if (scene()) { scene()->onSimulation(sdt); }
+	if (scene()) {
+		// Compute target motion in parallel, each target commits its new frame (in order) from its onSimulation() call below
+		BEGIN_TRACE_EVENT("targetUpdate");
+		if (notNull(m_simThread)) {
+			// Player movement and target motion run on the simulation thread, just apply its latest state
+			m_simThread->syncPlayer(scene()->typedEntity<PlayerEntity>("player"), typedScene<PhysicsScene>()->collisionTreeVersion());
+			m_simThread->syncTargets(targetArray, sess->trajectoryLogger(), activeCamera()->frame().translation, scene()->time());
+			m_simThread->applySnapshot();
+		}
+		else {
+			const SimTime targetTime = scene()->time() + (isNaN(sdt) ? 0.0 : sdt);
+			m_jobPool->parallelFor(targetArray.size(), [&](int i) {
+				targetArray[i]->updateMotion(targetTime, sdt);
+			});
+		}
+		END_TRACE_EVENT();
+		scene()->onSimulation(sdt);
+	}
 
 	// make sure mouse sensitivity is set right
 	if (m_userSettingsMode) {
@@ -938,7 +1183,7 @@ void App::onSimulation(RealTime rdt, SimTime sdt, SimTime idt) {
 		m_userSettingsWindow->setVisible(m_userSettingsMode);		// Make sure window stays coherent w/ user settings mode
 	}
 
-	const RealTime now = System::time();
+	const RealTime now = SimClock::time();
 	for (int p = 0; p < projectileArray.size(); ++p) {
 		const Projectile& projectile = projectileArray[p];
 
@@ -989,6 +1234,8 @@ void App::onSimulation(RealTime rdt, SimTime sdt, SimTime idt) {
 		debugWindow->setRect(Rect2D::xywh(0.0f, 0.0f, (float)window()->width(), debugWindow->rect().height()));
 	}
 	   
+	updatePrefetch();
+
 	// Check for completed session
 	if (sess->moveOn) {
 		String nextSess = userStatusTable.getNextSession(userTable.currentUser);
@@ -1242,16 +1489,17 @@ void App::drawHUD(RenderDevice *rd) {
 			const int segments = sessConfig->hud.cooldownSubdivisions;
 			int segsToLight = static_cast<int>(ceilf((1 - sess->weaponCooldownPercent())*segments));
 			// Create the segments
+			Array<Vector2> verts;
+			verts.clearAndSetMemoryManager(m_frameArena);
 			for (int i = 0; i < segsToLight; i++) {
 				const float inc = static_cast<float>(2 * pi() / segments);
 				const float theta = -i * inc;
 				Vector2 center = Vector2(rd->viewport().width() / 2.0f, rd->viewport().height() / 2.0f);
-				Array<Vector2> verts = {
-					center + Vector2(oRad*sin(theta), -oRad * cos(theta)),
+				verts.fastClear();
+				verts.append(center + Vector2(oRad*sin(theta), -oRad * cos(theta)),
 					center + Vector2(oRad*sin(theta + inc), -oRad * cos(theta + inc)),
 					center + Vector2(iRad*sin(theta + inc), -iRad * cos(theta + inc)),
-					center + Vector2(iRad*sin(theta), -iRad * cos(theta))
-				};
+					center + Vector2(iRad*sin(theta), -iRad * cos(theta)));
 				Draw::poly2D(verts, rd, sessConfig->hud.cooldownColor);
 			}
 		}
@@ -1306,7 +1554,7 @@ void App::drawHUD(RenderDevice *rd) {
 
 /** Method for handling weapon fire */
 shared_ptr<TargetEntity> App::fire(bool destroyImmediately) {
-    BEGIN_PROFILER_EVENT("fire");
+    BEGIN_TRACE_EVENT("fire");
 	Point3 aimPoint = activeCamera()->frame().translation + activeCamera()->frame().lookVector() * 1000.0f;
 	bool destroyedTarget = false;
 	static bool hitTarget = false;
@@ -1315,20 +1563,20 @@ shared_ptr<TargetEntity> App::fire(bool destroyImmediately) {
 
 	if (m_hitScan) {
 		const Ray& ray = activeCamera()->frame().lookRay();		// Use the camera lookray for hit detection
-		Array<shared_ptr<Entity>> dontHit = { m_explosion, m_lastDecal, m_firstDecal };
-		for (auto projectile : projectileArray) {
-			dontHit.append(projectile.entity);
-		}
-		for (auto target : targetArray) {
-			dontHit.append(target);
-		}
-		// Check for closest hit
-		float closest = finf();
+		// Check for closest hit, starting w/ a single occlusion query against the (cached) static scene geometry
+		float closest = typedScene<PhysicsScene>()->staticIntersectRay(ray);
 		int closestIndex = -1;
-		scene()->intersect(ray, closest, false, dontHit);
-		for (int t = 0; t < targetArray.size(); ++t) {
-			if (targetArray[t]->intersect(ray, closest)) {
-				closestIndex = t;
+		// Find targets w/ bounding spheres along the ray, then refine against the models (nearest first) where they were displayed.
+		// The BVH is built once the targets are posed (see onPose()), it is only rebuilt here if targets were spawned/destroyed since.
+		if (m_targetBVHDirty) {
+			m_targetBVH.rebuild(targetArray);
+			m_targetBVHDirty = false;
+		}
+		m_targetBVH.intersectRay(ray, closest, m_hitCandidates);
+		for (const TargetBVH::Candidate& candidate : m_hitCandidates) {
+			if (candidate.distance > closest) break;		// Sorted, so no remaining candidate can be closer
+			if (targetArray[candidate.index]->intersectAsDisplayed(ray, closest)) {
+				closestIndex = candidate.index;
 			}
 		}
 
@@ -1369,10 +1617,10 @@ shared_ptr<TargetEntity> App::fire(bool destroyImmediately) {
 				// create explosion animation
 				CFrame explosionFrame = targetArray[closestIndex]->frame();
 				explosionFrame.rotation = activeCamera()->frame().rotation;
-				const shared_ptr<VisibleEntity> newExplosion = VisibleEntity::create("explosion", scene().get(), m_explosionModels[target->scaleIndex()], explosionFrame);
+				const shared_ptr<VisibleEntity> newExplosion = VisibleEntity::create("explosion", scene().get(), explosionModel(target->scaleIndex()), explosionFrame);
 				scene()->insert(newExplosion);
 				m_explosion = newExplosion;
-				m_explosionEndTime = System::time() + 0.1f; // make explosion end in 0.5 seconds
+				m_explosionEndTime = SimClock::time() + 0.1f; // make explosion end in 0.5 seconds
 				sess->countDestroy();
 				respawned = target->respawn();
 				// check for respawn
@@ -1386,18 +1634,9 @@ shared_ptr<TargetEntity> App::fire(bool destroyImmediately) {
 				if (target->destinations().size() == 0 && respawned) {
 					sess->randomizePosition(target);
 				}
-                BEGIN_PROFILER_EVENT("fire/changeColor");
-                    BEGIN_PROFILER_EVENT("fire/clone");
-				        shared_ptr<ArticulatedModel::Pose> pose = dynamic_pointer_cast<ArticulatedModel::Pose>(targetArray[closestIndex]->pose()->clone());
-                    END_PROFILER_EVENT();
-                    BEGIN_PROFILER_EVENT("fire/materialSet");
-						shared_ptr<UniversalMaterial> mat = m_materials[min((int)(target->health()*m_MatTableSize), m_MatTableSize-1)];
-				        pose->materialTable.set("core/icosahedron_default", mat);
-                    END_PROFILER_EVENT();
-                    BEGIN_PROFILER_EVENT("fire/setPose");
-				        targetArray[closestIndex]->setPose(pose);
-                    END_PROFILER_EVENT();
-                END_PROFILER_EVENT();
+                BEGIN_TRACE_EVENT("fire/changeColor");
+				target->setPose(m_targetPoses->healthPose(target->health()));		// Prebuilt (shared) pose for this health level
+                END_TRACE_EVENT();
 			}
 		}
 		else hitTarget = false;
@@ -1424,7 +1663,7 @@ shared_ptr<TargetEntity> App::fire(bool destroyImmediately) {
 		bullet->setTrack(track);
 		*/
 
-		projectileArray.push(Projectile(bullet, System::time() + 1.0f));
+		projectileArray.push(Projectile(bullet, SimClock::time() + 1.0f));
 		scene()->insert(bullet);
 	}
 
@@ -1442,7 +1681,9 @@ shared_ptr<TargetEntity> App::fire(bool destroyImmediately) {
 		// compute world intersection
 		const Ray& ray = activeCamera()->frame().lookRay();
 		float hitDist = finf();
-		Array<shared_ptr<Entity>> dontHit = { m_explosion, m_lastDecal, m_firstDecal };
+		Array<shared_ptr<Entity>> dontHit;
+		dontHit.clearAndSetMemoryManager(m_frameArena);
+		dontHit.append(m_explosion, m_lastDecal, m_firstDecal);
 		for (auto projectile : projectileArray) {
 			dontHit.append(projectile.entity);
 		}
@@ -1471,7 +1712,7 @@ shared_ptr<TargetEntity> App::fire(bool destroyImmediately) {
 		m_lastDecal = m_firstDecal;
 		m_firstDecal = newDecal;
 	}
-    END_PROFILER_EVENT();
+    END_TRACE_EVENT();
 	return target;
 }
 
@@ -1484,7 +1725,7 @@ void App::clearTargets() {
 
 /** Handle user input here */
 void App::onUserInput(UserInput* ui) {
-	BEGIN_PROFILER_EVENT("onUserInput");
+	BEGIN_TRACE_EVENT("onUserInput");
 	static bool haveReleased = false;
 	static bool fired = false;
 	GApp::onUserInput(ui);
@@ -1492,11 +1733,23 @@ void App::onUserInput(UserInput* ui) {
 
 	const shared_ptr<PlayerEntity>& player = scene()->typedEntity<PlayerEntity>("player");
 	if (!m_userSettingsMode && notNull(player)) {
-		player->updateFromInput(ui);
+		if (player->externalMotion() && notNull(m_simThread)) {
+			// The view turns here (as w/o the thread), the simulation thread moves the player w/ the queued input
+			player->updateViewFromInput(ui);
+			m_simThread->submitInput(player, Vector2(ui->getX(), ui->getY()));
+			m_simThread->applySnapshot();
+		}
+		else {
+			player->updateFromInput(ui);
+		}
+		activeCamera()->setFrame(player->getCameraFrame());		// Fire from the simulated (not interpolated) position w/ the latest view
 	}
 	else {	// Zero the player velocity and rotation when in the setting menu
 		player->setDesiredOSVelocity(Vector3::zero());
 		player->setDesiredAngularVelocity(0.0, 0.0);
+		if (player->externalMotion() && notNull(m_simThread)) {
+			m_simThread->submitInput(player, Vector2::zero());
+		}
 	}
 
 	// Handle fire up/down events
@@ -1555,6 +1808,12 @@ void App::onUserInput(UserInput* ui) {
 		}
 	}
 	
+	for (GKey captureTrace : keyMap.map["captureTrace"]) {
+		if (ui->keyPressed(captureTrace)) {
+			startTrace();
+		}
+	}
+
 	for (GKey dummyShoot : keyMap.map["dummyShoot"]) {
 		if (ui->keyPressed(dummyShoot) && (sess->presentationState == PresentationState::feedback)) {
 			fire(true); // Fire at dummy target here...
@@ -1567,23 +1826,54 @@ void App::onUserInput(UserInput* ui) {
 	}
 
 	activeCamera()->filmSettings().setSensitivity(sceneBrightness);
-    END_PROFILER_EVENT();
+    END_TRACE_EVENT();
 }
 
 void App::destroyTarget(int index) {
 	// Not a reference because we're about to manipulate the array
-	const shared_ptr<VisibleEntity> target = targetArray[index];
+	const shared_ptr<TargetEntity> target = targetArray[index];
 	// Remove the target from the target array
 	targetArray.fastRemove(index);
-	// Remove the target from the scene
+	m_targetBVHDirty = true;
+	// Remove the target from the scene and keep it for reuse
 	scene()->removeEntity(target->name());
+	m_targetPool.release(target);
 }
 
 void App::onPose(Array<shared_ptr<Surface> >& surface, Array<shared_ptr<Surface2D> >& surface2D) {
+	// Pose targets and the camera between the last two simulation steps, the simulated target frames are restored below
+	const shared_ptr<PlayerEntity>& player = scene()->typedEntity<PlayerEntity>("player");
+	m_simulatedFrames.fastClear();
+	if (m_simInterpolation < 1.0f) {
+		for (const shared_ptr<TargetEntity>& target : targetArray) {
+			m_simulatedFrames.append(target->frame());
+			target->setFrame(target->previousFrame().lerp(target->frame(), m_simInterpolation));
+		}
+	}
+	if (notNull(player)) {
+		// Only the camera position is interpolated, the view direction is always the latest (from input)
+		CFrame camera = player->getCameraFrame();
+		camera.translation += (player->previousFrame().translation - player->frame().translation) * (1.0f - m_simInterpolation);
+		activeCamera()->setFrame(camera);
+	}
+
 	GApp::onPose(surface, surface2D);
 
 	typedScene<PhysicsScene>()->poseExceptExcluded(surface, "player");
 
+	for (int i = 0; i < m_simulatedFrames.size(); i++) {
+		targetArray[i]->setFrame(m_simulatedFrames[i]);
+	}
+
+	// Build the hit test BVH from the bounds just posed, shots are tested against them until the next pose
+	m_targetBVH.rebuild(targetArray);
+	m_targetBVHDirty = false;
+
+	poseWeapon(surface);
+}
+
+void App::poseWeapon(Array<shared_ptr<Surface>>& surface) {
+	m_weaponSurfaceStart = surface.size();
 	if (sessConfig->weapon.renderModel) {
 		const float yScale = -0.12f;
 		const float zScale = -yScale * 0.5f;
@@ -1593,28 +1883,45 @@ void App::onPose(Array<shared_ptr<Surface> >& surface, Array<shared_ptr<Surface2
 		const CFrame prevWeaponPos = CFrame::fromXYZYPRDegrees(0.3f, -0.4f + prevLookY * yScale, -1.1f + prevLookY * zScale, 10, 5);
 		m_viewModel->pose(surface, m_weaponFrame, activeCamera()->previousFrame() * prevWeaponPos, nullptr, nullptr, nullptr, Surface::ExpressiveLightScatteringProperties());
 	}
+	m_weaponSurfaceCount = surface.size() - m_weaponSurfaceStart;
 }
 
-void App::onGraphics2D(RenderDevice* rd, Array<shared_ptr<Surface2D>>& posed2D) {
-    // Render 2D objects like Widgets.  These do not receive tone mapping or gamma correction.
-	// Track the instantaneous frame duration (no smoothing) in a circular queue
-	if (m_frameDurationQueue.length() > MAX_HISTORY_TIMING_FRAMES) {
-		m_frameDurationQueue.dequeue();
-	}
-	{
-		const float f = rd->stats().frameRate;
-		const float t = 1.0f / f;
-		m_frameDurationQueue.enqueue(t);
+void App::lateLatchView() {
+	const shared_ptr<PlayerEntity>& player = scene()->typedEntity<PlayerEntity>("player");
+	if (isNull(player)) return;
+
+	BEGIN_TRACE_EVENT("Late latch");
+	// Drain the event queue again for the mouse motion since the user input phase
+	processGEventQueue();
+	m_inputSampleTime = System::time();
+
+	// The next frame's processGEventQueue() clears this drain's button/key transitions, keep them to replay then
+	Array<GKey> keys;
+	userInput->pressedKeys(keys);
+	for (GKey key : keys) m_lateLatchKeys.append(LateLatchKey{ key, true });
+	keys.fastClear();
+	userInput->releasedKeys(keys);
+	for (GKey key : keys) m_lateLatchKeys.append(LateLatchKey{ key, false });
+
+	// Update the view direction only (the camera position stays interpolated from the simulation)
+	player->updateViewFromInput(userInput);
+	if (player->externalMotion() && notNull(m_simThread)) {
+		m_simThread->submitInput(player, m_userSettingsMode ? Vector2::zero() : Vector2(userInput->getX(), userInput->getY()));
 	}
-
-	float recentMin = finf();
-	float recentMax = -finf();
-	for (int i = 0; i < m_frameDurationQueue.length(); ++i) {
-		const float t = m_frameDurationQueue[i];
-		recentMin = min(recentMin, t);
-		recentMax = max(recentMax, t);
+	CFrame camera = activeCamera()->frame();
+	camera.rotation = player->getCameraFrame().rotation;
+	activeCamera()->setFrame(camera);
+
+	// Re-pose the weapon w/ the new view
+	if (m_weaponSurfaceCount > 0) {
+		m_posed3D.remove(m_weaponSurfaceStart, m_weaponSurfaceCount);
+		poseWeapon(m_posed3D);
 	}
+	END_TRACE_EVENT();
+}
 
+void App::onGraphics2D(RenderDevice* rd, Array<shared_ptr<Surface2D>>& posed2D) {
+    // Render 2D objects like Widgets.  These do not receive tone mapping or gamma correction.
 	rd->push2D(); {
 		const float scale = rd->viewport().width() / 1920.0f;
 		rd->setBlendFunc(RenderDevice::BLEND_SRC_ALPHA, RenderDevice::BLEND_ONE_MINUS_SRC_ALPHA);
@@ -1623,16 +1930,24 @@ void App::onGraphics2D(RenderDevice* rd, Array<shared_ptr<Surface2D>>& posed2D)
 		if (renderFPS) {
 			String msg;
 
+			// Frame timing over the last MAX_HISTORY_TIMING_FRAMES (measured) frames
+			const float meanFrameTime = m_frameStats.mean();
+			const int measuredFps = (meanFrameTime > 0.0f) ? iRound(1.0f / meanFrameTime) : 0;
 			if (window()->settings().refreshRate > 0) {
-				msg = format("%d measured / %d requested fps",
-					iRound(renderDevice->stats().smoothFrameRate),
-					window()->settings().refreshRate);
+				msg = format("%d measured / %d requested fps", measuredFps, window()->settings().refreshRate);
 			}
 			else {
-				msg = format("%d fps", iRound(renderDevice->stats().smoothFrameRate));
+				msg = format("%d fps", measuredFps);
 			}
 
-			msg += format(" | %.1f min/%.1f avg/%.1f max ms", recentMin * 1000.0f, 1000.0f / renderDevice->stats().smoothFrameRate, 1000.0f * recentMax);
+			const float p[3] = { 0.5f, 0.95f, 0.99f };
+			RealTime percentiles[3];
+			m_frameStats.histogram().percentiles(p, percentiles, 3);
+			msg += format(" | %.1f min/%.1f avg/%.1f max ms", 1000.0f * m_frameStats.minimum(), 1000.0f * meanFrameTime, 1000.0f * m_frameStats.maximum());
+			msg += format(" | %.1f p50/%.1f p95/%.1f p99 ms", 1000.0 * percentiles[0], 1000.0 * percentiles[1], 1000.0 * percentiles[2]);
+			if (startupConfig.developerMode) {
+				msg += format(" | %d allocs", (int)m_frameAllocations);
+			}
 			outputFont->draw2D(rd, msg, Point2(rd->viewport().width()*0.75f, rd->viewport().height()*0.05f).floor(), floor(20.0f*scale), Color3::yellow());
 		}
 
@@ -1648,10 +1963,10 @@ void App::onGraphics2D(RenderDevice* rd, Array<shared_ptr<Surface2D>>& posed2D)
 
 		// Reticle
 		UserConfig* user = userTable.getCurrentUser();
-		float tscale = max(min(((float)(System::time() - sess->lastFireTime()) / user->reticleShrinkTimeS), 1.0f), 0.0f);
+		float tscale = max(min(((float)(SimClock::time() - sess->lastFireTime()) / user->reticleShrinkTimeS), 1.0f), 0.0f);
 		float rScale = tscale * user->reticleScale[0] + (1.0f - tscale)*user->reticleScale[1];
 		Color4 rColor = user->reticleColor[1] * (1.0f - tscale) + user->reticleColor[0] * tscale;
-		Draw::rect2D(((reticleTexture->rect2DBounds() - reticleTexture->vector2Bounds() / 2.0f))*rScale / 2.0f + rd->viewport().wh() / 2.0f, rd, rColor, reticleTexture);
+		reticleAtlas->draw(rd, m_lastReticleLoaded, rd->viewport().wh() / 2.0f, rScale / 2.0f, rColor);
 
 		// Handle the feedback message
 		String message = sess->getFeedbackMessage();
@@ -1669,25 +1984,125 @@ void App::onGraphics2D(RenderDevice* rd, Array<shared_ptr<Surface2D>>& posed2D)
 
 /** Set the currently reticle by index */
 void App::setReticle(const int r) {
-	int idx = clamp(0, r, numReticles);
-	if(idx == m_lastReticleLoaded) return;	// Nothing to do here, setting current reticle
-	if (r < numReticles) {
-		reticleTexture = Texture::fromFile(System::findDataFile(format("gui/reticle/reticle-%03d.png", idx)));
-	}
-	else {
-		// This special case is added to allow a custom reticle not in the gui/reticle/reticle-[x].png format
-		reticleTexture = Texture::fromFile(System::findDataFile("gui/reticle.png"));
-	}
-	m_lastReticleLoaded = idx;
+	// All reticles are preloaded into the reticle atlas (see onInit())
+	m_lastReticleLoaded = clamp(0, r, numReticles);
 }
 
 void App::onCleanup() {
 	// Called after the application loop ends.  Place a majority of cleanup code
 	// here instead of in the constructor so that exceptions can be caught.
+	if (TraceRecorder::recording()) {
+		stopTrace();
+	}
+	TraceRecorder::shutdown();
+}
+
+void App::startTrace() {
+	if (TraceRecorder::recording()) return;
+	TraceRecorder::start();
+	m_traceFramesLeft = max(1, startupConfig.traceFrames);
+	logPrintf("Recording a trace of %d frames\n", m_traceFramesLeft);
+}
+
+void App::stopTrace() {
+	if (!FileSystem::isDirectory(String("../results"))) {
+		FileSystem::createDirectory(String("../results"));
+	}
+	TraceRecorder::stopAndWrite("../results/trace_" + Logger::genFileTimestamp() + ".json");
+}
+
+void App::updateTrace() {
+	if (TraceRecorder::recording()) {
+		if (--m_traceFramesLeft <= 0) {
+			stopTrace();
+		}
+	}
+	else if (startupConfig.traceStartFrame >= 0 && m_frameIndex == uint64(startupConfig.traceStartFrame)) {
+		startTrace();
+	}
+}
+
+void App::waitForFrame() {
+	BEGIN_TRACE_EVENT("Wait");
+	m_waitWatch.tick(); {
+		RealTime nowAfterLoop = System::time();
+
+		// Compute accumulated time
+		RealTime cumulativeTime = nowAfterLoop - m_lastWaitTime;
+
+		debugAssert(m_wallClockTargetDuration < finf());
+		// Perform wait for actual time needed
+		RealTime duration = m_wallClockTargetDuration;
+		if (!window()->hasFocus() && m_lowerFrameRateInBackground) {
+			// Lower frame rate to 4fps
+			duration = 1.0 / 4.0;
+		}
+
+		// Predict the cost of the rest of the frame (logged even when the frame start isn't scheduled from it)
+		const FrameScheduler::Phase firstPhase = (submitToDisplayMode() == SubmitToDisplayMode::MINIMIZE_LATENCY) ?
+			FrameScheduler::Input : FrameScheduler::Render;
+		m_predictedFrameCost = m_frameScheduler.predict(firstPhase);
+
+		RealTime desiredWaitTime;
+		if (sessConfig->render.jitFrameStart) {
+			// Present on a grid of deadlines one duration apart and start the frame the predicted cost (+ margin) before its deadline.
+			// The deadline is pulled back onto the grid when a frame runs late (or the duration shrinks).
+			const RealTime earliest = nowAfterLoop + m_predictedFrameCost + m_frameScheduler.margin();
+			m_frameDeadline = clamp(m_frameDeadline + duration, earliest, earliest + duration);
+			desiredWaitTime = max(0.0, m_frameDeadline - earliest);
+		}
+		else {
+			desiredWaitTime = max(0.0, duration - cumulativeTime);
+		}
+
+		if (m_framePacer.mode() == FramePacer::Mode::Hybrid) {
+			// Sleep to just before the deadline then spin (no overshoot estimate needed)
+			if (desiredWaitTime > 0.0) {
+				m_framePacer.waitUntil(nowAfterLoop + desiredWaitTime);
+			}
+			m_lastWaitTime = System::time();
+		}
+		else {
+			onWait(max(0.0, desiredWaitTime - m_lastFrameOverWait) * 0.97);
+
+			// Update wait timers
+			m_lastWaitTime = System::time();
+			RealTime actualWaitTime = m_lastWaitTime - nowAfterLoop;
+
+			// Learn how much onWait appears to overshoot by and compensate
+			double thisOverWait = actualWaitTime - desiredWaitTime;
+			if (desiredWaitTime > 0.0) {
+				m_framePacer.recordWakeError(thisOverWait);
+			}
+			if (G3D::abs(thisOverWait - m_lastFrameOverWait) / max(G3D::abs(m_lastFrameOverWait), G3D::abs(thisOverWait)) > 0.4) {
+				// Abruptly change our estimate
+				m_lastFrameOverWait = thisOverWait;
+			}
+			else {
+				// Smoothly change our estimate
+				m_lastFrameOverWait = lerp(m_lastFrameOverWait, thisOverWait, 0.1);
+			}
+		}
+	}  m_waitWatch.tock();
+	END_TRACE_EVENT();
 }
 
 /** Overridden (optimized) oneFrame() function to improve latency */
 void App::oneFrame() {
+	// Free last frame's temporaries and count the heap allocations it made
+	m_frameArena->reset();
+	const uint64 allocations = FrameArena::threadAllocationCount();
+	m_frameAllocations = allocations - m_frameStartAllocations;
+	m_frameStartAllocations = allocations;
+	m_frameIndex++;
+
+	updateTrace();
+	TraceRecorder::begin("Frame");
+	if (notNull(m_headless)) {
+		oneHeadlessFrame();
+		TraceRecorder::end();
+		return;
+	}
 
     // Wait
     // Note: we might end up spending all of our time inside of
@@ -1695,41 +2110,10 @@ void App::oneFrame() {
     // though, because while we're sleeping the CPU the GPU is working
     // to catch up.    
     if ((submitToDisplayMode() == SubmitToDisplayMode::MINIMIZE_LATENCY)) {
-        BEGIN_PROFILER_EVENT("Wait");
-        m_waitWatch.tick(); {
-            RealTime nowAfterLoop = System::time();
-
-            // Compute accumulated time
-            RealTime cumulativeTime = nowAfterLoop - m_lastWaitTime;
-
-            debugAssert(m_wallClockTargetDuration < finf());
-            // Perform wait for actual time needed
-            RealTime duration = m_wallClockTargetDuration;
-            if (!window()->hasFocus() && m_lowerFrameRateInBackground) {
-                // Lower frame rate to 4fps
-                duration = 1.0 / 4.0;
-            }
-            RealTime desiredWaitTime = max(0.0, duration - cumulativeTime);
-            onWait(max(0.0, desiredWaitTime - m_lastFrameOverWait) * 0.97);
-
-            // Update wait timers
-            m_lastWaitTime = System::time();
-            RealTime actualWaitTime = m_lastWaitTime - nowAfterLoop;
-
-            // Learn how much onWait appears to overshoot by and compensate
-            double thisOverWait = actualWaitTime - desiredWaitTime;
-            if (G3D::abs(thisOverWait - m_lastFrameOverWait) / max(G3D::abs(m_lastFrameOverWait), G3D::abs(thisOverWait)) > 0.4) {
-                // Abruptly change our estimate
-                m_lastFrameOverWait = thisOverWait;
-            }
-            else {
-                // Smoothly change our estimate
-                m_lastFrameOverWait = lerp(m_lastFrameOverWait, thisOverWait, 0.1);
-            }
-        }  m_waitWatch.tock();
-        END_PROFILER_EVENT();
+        waitForFrame();
     }
 
+    FrameInfo frameInfo;
     for (int repeat = 0; repeat < max(1, m_renderPeriod); ++repeat) {
         Profiler::nextFrame();
         m_lastTime = m_now;
@@ -1740,17 +2124,23 @@ void App::oneFrame() {
         m_userInputWatch.tick();
         if (manageUserInput) {
             processGEventQueue();
+            m_inputSampleTime = System::time();
+            // Replay key/button transitions picked up by the last frame's late latch
+            for (const LateLatchKey& k : m_lateLatchKeys) {
+                HeadlessDriver::injectKey(userInput, k.key, k.pressed);
+            }
+            m_lateLatchKeys.fastClear();
         }
         onAfterEvents();
         onUserInput(userInput);
         m_userInputWatch.tock();
 
         // Network
-        BEGIN_PROFILER_EVENT("GApp::onNetwork");
+        BEGIN_TRACE_EVENT("GApp::onNetwork");
         m_networkWatch.tick();
         onNetwork();
         m_networkWatch.tock();
-        END_PROFILER_EVENT();
+        END_TRACE_EVENT();
 
         // Logic
         m_logicWatch.tick();
@@ -1761,37 +2151,65 @@ void App::oneFrame() {
 
         // Simulation
         m_simulationWatch.tick();
-        BEGIN_PROFILER_EVENT("Simulation");
+        BEGIN_TRACE_EVENT("Simulation");
         {
             RealTime rdt = timeStep;
 
-            SimTime sdt = m_simTimeStep;
-            if (sdt == MATCH_REAL_TIME_TARGET) {
-                sdt = m_wallClockTargetDuration;
+            SimTime idt = m_wallClockTargetDuration;
+            SimTime frameSimTime = 0.0;
+
+            if (sessConfig->timing.simulationRate > 0.0f) {
+                // Fixed timestep, run as many steps as real time has accumulated (and interpolate poses for the remainder)
+                const SimTime sdt = 1.0 / sessConfig->timing.simulationRate;
+                m_simAccumulator = min(m_simAccumulator + rdt * m_simTimeScale, m_maxSimLag);
+                while (m_simAccumulator >= sdt) {
+                    onBeforeSimulation(sdt, sdt, idt);
+                    onSimulation(sdt, sdt, idt);
+                    onAfterSimulation(sdt, sdt, idt);
+
+                    m_previousSimTimeStep = float(sdt);
+                    setSimTime(simTime() + sdt);
+                    m_simAccumulator -= sdt;
+                    frameSimTime += sdt;
+                }
+                m_simInterpolation = float(m_simAccumulator / sdt);
             }
-            else if (sdt == REAL_TIME) {
-                sdt = float(timeStep);
+            else {
+                SimTime sdt = m_simTimeStep;
+                if (sdt == MATCH_REAL_TIME_TARGET) {
+                    sdt = m_wallClockTargetDuration;
+                }
+                else if (sdt == REAL_TIME) {
+                    sdt = float(timeStep);
+                }
+                sdt *= m_simTimeScale;
+
+                onBeforeSimulation(rdt, sdt, idt);
+                onSimulation(rdt, sdt, idt);
+                onAfterSimulation(rdt, sdt, idt);
+
+                m_previousSimTimeStep = float(sdt);
+                setSimTime(simTime() + sdt);
+                m_simAccumulator = 0.0;
+                m_simInterpolation = 1.0f;
+                frameSimTime = sdt;
             }
-            sdt *= m_simTimeScale;
 
-            SimTime idt = m_wallClockTargetDuration;
-
-            onBeforeSimulation(rdt, sdt, idt);
-            onSimulation(rdt, sdt, idt);
-            onAfterSimulation(rdt, sdt, idt);
+            // Logged (w/ the phase timings) once the frame is presented
+            frameInfo.rdt = float(rdt);
+            frameInfo.sdt = float(frameSimTime);
+            frameInfo.idt = float(idt);
 
-            m_previousSimTimeStep = float(sdt);
             m_previousRealTimeStep = float(rdt);
             setRealTime(realTime() + rdt);
-            setSimTime(simTime() + sdt);
         }
         m_simulationWatch.tock();
-        END_PROFILER_EVENT();
+        END_TRACE_EVENT();
     }
 
 
     // Pose
-    BEGIN_PROFILER_EVENT("Pose");
+    BEGIN_TRACE_EVENT("Pose");
     m_poseWatch.tick(); {
         m_posed3D.fastClear();
         m_posed2D.fastClear();
@@ -1802,7 +2220,7 @@ void App::oneFrame() {
         // it allows us to trigger the TAA code.
 		activeCamera()->onPose(m_posed3D);
     } m_poseWatch.tock();
-    END_PROFILER_EVENT();
+    END_TRACE_EVENT();
 
     // Wait
     // Note: we might end up spending all of our time inside of
@@ -1810,40 +2228,9 @@ void App::oneFrame() {
     // though, because while we're sleeping the CPU the GPU is working
     // to catch up.    
     if ((submitToDisplayMode() != SubmitToDisplayMode::MINIMIZE_LATENCY)) {
-        BEGIN_PROFILER_EVENT("Wait");
-        m_waitWatch.tick(); {
-            RealTime nowAfterLoop = System::time();
-
-            // Compute accumulated time
-            RealTime cumulativeTime = nowAfterLoop - m_lastWaitTime;
-
-            debugAssert(m_wallClockTargetDuration < finf());
-            // Perform wait for actual time needed
-            RealTime duration = m_wallClockTargetDuration;
-            if (!window()->hasFocus() && m_lowerFrameRateInBackground) {
-                // Lower frame rate to 4fps
-                duration = 1.0 / 4.0;
-            }
-            RealTime desiredWaitTime = max(0.0, duration - cumulativeTime);
-            onWait(max(0.0, desiredWaitTime - m_lastFrameOverWait) * 0.97);
-
-            // Update wait timers
-            m_lastWaitTime = System::time();
-            RealTime actualWaitTime = m_lastWaitTime - nowAfterLoop;
-
-            // Learn how much onWait appears to overshoot by and compensate
-            double thisOverWait = actualWaitTime - desiredWaitTime;
-            if (G3D::abs(thisOverWait - m_lastFrameOverWait) / max(G3D::abs(m_lastFrameOverWait), G3D::abs(thisOverWait)) > 0.4) {
-                // Abruptly change our estimate
-                m_lastFrameOverWait = thisOverWait;
-            }
-            else {
-                // Smoothly change our estimate
-                m_lastFrameOverWait = lerp(m_lastFrameOverWait, thisOverWait, 0.1);
-            }
-        }  m_waitWatch.tock();
-        END_PROFILER_EVENT();
+        waitForFrame();
     }
+    const RealTime renderStart = System::time();
 
     // Graphics
     debugAssertGLOk();
@@ -1851,13 +2238,18 @@ void App::oneFrame() {
         swapBuffers();
     }
 
+    // Update the view w/ the latest mouse input right before rendering
+    if (sessConfig->render.lateLatchView && manageUserInput && !m_userSettingsMode) {
+        lateLatchView();
+    }
+
     if (notNull(m_gazeTracker)) {
-        BEGIN_PROFILER_EVENT("Gaze Tracker");
+        BEGIN_TRACE_EVENT("Gaze Tracker");
         sampleGazeTrackerData();
-        END_PROFILER_EVENT();
+        END_TRACE_EVENT();
     }
 
-    BEGIN_PROFILER_EVENT("Graphics");
+    BEGIN_TRACE_EVENT("Graphics");
     renderDevice->beginFrame();
     m_widgetManager->onBeforeGraphics();
     m_graphicsWatch.tick(); {
@@ -1868,10 +2260,47 @@ void App::oneFrame() {
         } renderDevice->popState();
     }  m_graphicsWatch.tock();
     renderDevice->endFrame();
+    const RealTime submitTime = System::time();
     if ((submitToDisplayMode() == SubmitToDisplayMode::MINIMIZE_LATENCY) && (!renderDevice->swapBuffersAutomatically())) {
         swapBuffers();
     }
-    END_PROFILER_EVENT();
+    END_TRACE_EVENT();
+
+    // Measure the (present to present) frame duration
+    const RealTime presentTime = System::time();
+    const bool inTask = (sess->presentationState == PresentationState::task);
+    if (m_lastPresentTime > 0.0) {
+        const RealTime frameTime = presentTime - m_lastPresentTime;
+        m_frameStats.add(frameTime);
+        if (inTask) {
+            m_sessionFrameStats.add(frameTime);
+        }
+    }
+    m_lastPresentTime = presentTime;
+
+    // Learn this frame's phase costs for the next frame's prediction
+    const RealTime phaseCosts[FrameScheduler::NumPhases] = {
+        m_userInputWatch.elapsedTime(),
+        m_simulationWatch.elapsedTime(),
+        m_poseWatch.elapsedTime(),
+        presentTime - renderStart
+    };
+    m_frameScheduler.addFrame(phaseCosts);
+
+    // Log the frame (once per frame, not per simulation step) w/ its phase timings
+    if (inTask) {
+        frameInfo.time = Logger::getFileTime();
+        frameInfo.frameIndex = m_frameIndex;
+        frameInfo.userInputTime = float(m_userInputWatch.elapsedTime());
+        frameInfo.simulationTime = float(m_simulationWatch.elapsedTime());
+        frameInfo.poseTime = float(m_poseWatch.elapsedTime());
+        frameInfo.waitTime = float(m_waitWatch.elapsedTime());
+        frameInfo.graphicsTime = float(m_graphicsWatch.elapsedTime());
+        frameInfo.inputToSubmitTime = float(submitTime - m_inputSampleTime);
+        frameInfo.predictedCost = float(m_predictedFrameCost);
+        frameInfo.actualCost = float(presentTime - m_lastWaitTime);
+        sess->accumulateFrameInfo(frameInfo);
+    }
 
     // Remove all expired debug shapes
     for (int i = 0; i < debugShapeArray.size(); ++i) {
@@ -1896,9 +2325,79 @@ void App::oneFrame() {
     if (m_endProgram && window()->requiresMainLoop()) {
         window()->popLoopBody();
     }
+    TraceRecorder::end();
 }
 
 
+void App::oneHeadlessFrame() {
+	Profiler::nextFrame();
+	const SimTime sdt = m_headless->timeStep();
+
+	// There is no one to use the user settings menu, keep it closed (sessions open it when they complete)
+	if (m_userSettingsMode) {
+		m_userSettingsMode = false;
+		m_userSettingsWindow->setVisible(false);
+	}
+
+	// Scripted/agent input (in place of the window's event queue)
+	const shared_ptr<PlayerEntity>& player = scene()->typedEntity<PlayerEntity>("player");
+	m_userInputWatch.tick();
+	userInput->beginEvents();
+	m_headless->applyInput(userInput, player, keyMap.map);
+	if (notNull(m_aimAgent)) {
+		// The agent aims/fires during the task and clicks through the start of the session
+		const GKey shootKey = keyMap.map["shoot"][0];
+		bool trigger = m_aimAgent->update((float)sdt, player, targetArray, sess->presentationState == PresentationState::task);
+		if (sess->presentationState == PresentationState::initial) {
+			trigger = !userInput->keyDown(shootKey);
+		}
+		if (trigger != userInput->keyDown(shootKey)) {
+			HeadlessDriver::injectKey(userInput, shootKey, trigger);
+		}
+	}
+	userInput->endEvents();
+	activeCamera()->setFrame(player->getCameraFrame());		// Apply scripted/agent view changes before firing
+	onAfterEvents();
+	onUserInput(userInput);
+	m_userInputWatch.tock();
+
+	m_logicWatch.tick();
+	onAI();
+	m_logicWatch.tock();
+
+	// Fixed timestep simulation (real time advances w/ simulation time)
+	m_simulationWatch.tick();
+	BEGIN_TRACE_EVENT("Simulation");
+	{
+		onBeforeSimulation(sdt, sdt, sdt);
+		onSimulation(sdt, sdt, sdt);
+		onAfterSimulation(sdt, sdt, sdt);
+		if (sess->presentationState == PresentationState::task) {
+			FrameInfo frameInfo(Logger::getFileTime(), float(sdt));
+			frameInfo.frameIndex = m_frameIndex;
+			frameInfo.idt = frameInfo.rdt = float(sdt);
+			sess->accumulateFrameInfo(frameInfo);
+		}
+
+		m_previousSimTimeStep = float(sdt);
+		m_previousRealTimeStep = float(sdt);
+		setRealTime(realTime() + sdt);
+		setSimTime(simTime() + sdt);
+		m_headless->advance();
+	}
+	m_simulationWatch.tock();
+	END_TRACE_EVENT();
+
+	// No pose/graphics, just keep the debug text from accumulating
+	debugText.fastClear();
+
+	// Exit once the duration has elapsed or all sessions are complete
+	const bool sessionsDone = (sess->presentationState == PresentationState::complete) && !sess->moveOn;
+	if (m_headless->finished() || sessionsDone) {
+		setExitCode(0);
+	}
+}
+
 // Tells C++ to invoke command-line main() function even on OS X and Win32.
 G3D_START_AT_MAIN();
 
@@ -1914,7 +2413,7 @@ int main(int argc, const char* argv[]) {
 
 	{
 		G3DSpecification spec;
-        spec.audio = startupConfig.audioEnable;
+        spec.audio = startupConfig.audioEnable && !startupConfig.headless;
 		initGLG3D(spec);
 	}
 
@@ -1930,6 +2429,13 @@ int main(int argc, const char* argv[]) {
 	settings.window.fullScreen = startupConfig.fullscreen;
 	settings.window.resizable = !settings.window.fullScreen;
 
+	if (startupConfig.headless) {
+		// Nothing is drawn in headless mode, just create a small hidden window (for the GL context)
+		settings.window.width = 640; settings.window.height = 480;
+		settings.window.fullScreen = false;
+		settings.window.visible = false;
+	}
+
     // V-sync off always
 	settings.window.asynchronous = true;
 	settings.window.caption = "First Person Science";
@@ -14,6 +14,22 @@
 #include "TargetEntity.h"
 #include "GuiElements.h"
 #include "PyLogger.h"
+#include "JobPool.h"
+#include "TargetPoseCache.h"
+#include "TargetBVH.h"
+#include "HeadlessDriver.h"
+#include "AimAgent.h"
+#include "SimulationThread.h"
+#include "FrameArena.h"
+#include "SessionPrefetcher.h"
+#include "TaskGraph.h"
+#include "AssetCache.h"
+#include "ReticleAtlas.h"
+#include "FramePacer.h"
+#include "FrameStats.h"
+#include "FrameScheduler.h"
+#include "TraceRecorder.h"
+#include "SimClock.h"
 
 class Session;
 class G3Dialog;
@@ -61,12 +77,12 @@ public:
 		m_velocity = velocity;
 		m_fade = fade;
 		m_timeout = timeout_s;
-		m_created = System::time();		// Capture the time at which this was created
+		m_created = SimClock::time();		// Capture the time at which this was created
 	}
 
 	bool draw(RenderDevice* rd, const Camera& camera, const Framebuffer& framebuffer) {
 		// Abort if the timeout has expired (return false to remove this combat text from the tracked array)
-		float time_existing = static_cast<float>(System::time() - m_created);
+		float time_existing = static_cast<float>(SimClock::time() - m_created);
 		if (time_existing > m_timeout) {
 			return false;
 		}
@@ -101,7 +117,7 @@ class App : public GApp {
 protected:
 	static const float TARGET_MODEL_ARRAY_SCALING;						///< Target model scale factor
 	static const float TARGET_MODEL_ARRAY_OFFSET;						///< Target model offset
-	static const int MAX_HISTORY_TIMING_FRAMES = 360;					///< Length of the history queue for m_frameDurationQueue
+	static const int MAX_HISTORY_TIMING_FRAMES = 360;					///< Window (in frames) of m_frameStats
 
 	shared_ptr<ArticulatedModel>    m_viewModel;						///< Model for the weapon
 	shared_ptr<Sound>               m_fireSound;						///< Sound for weapon firing
@@ -118,7 +134,7 @@ protected:
 	RealTime						m_explosionEndTime;					///< Time for end of explosion
 		
 	const int m_MatTableSize = 10;										///< Set this to set # of color "levels"
-	Array<shared_ptr<UniversalMaterial>>	m_materials;				///< This stores the color materials
+	shared_ptr<TargetPoseCache>		m_targetPoses;						///< Prebuilt target poses (by color and health level)
 
 	GuiDropDownList*				m_sessDropDown;						///< Dropdown menu for session selection
 	GuiDropDownList*				m_userDropDown;						///< Dropdown menu for user selection
@@ -129,19 +145,54 @@ protected:
 	shared_ptr<RenderControls>		m_renderControls;
 	shared_ptr<WeaponControls>		m_weaponControls;
 
-	Table<String, Array<shared_ptr<ArticulatedModel>>> m_targetModels;
+	Table<String, Any>				m_targetModelSpecs;					///< Model specification (scaled to 1m across) for each target id
+	Table<String, Array<shared_ptr<ArticulatedModel>>> m_targetModels;	///< Scaled models for each target id (created on first use)
 	const int m_modelScaleCount = 30;
 
-	Array<shared_ptr<ArticulatedModel>> m_explosionModels;
+	Any								m_explosionSpec;					///< Model specification for the explosion (w/o its texture)
+	Array<shared_ptr<ArticulatedModel>> m_explosionModels;				///< Scaled explosion models (created on first use)
+	const String					m_boundsCacheFile = "targetBounds.Any";	///< Cache of target model bounding boxes
+
+	/** Target model that hasn't been sized yet (listed by resolveTargetModels(), sized from the cache by prepareTargetModels() or by loadTargetModels()) */
+	struct UnsizedTargetModel {
+		String	id;
+		Any		spec;
+		String	file;											///< Model file (resolved on the main thread)
+		String	stamp;											///< Model file stamp for the cache entry
+		String	cacheKey;										///< Bounds cache key (from the spec hash)
+	};
+	Any								m_boundsCache;						///< Bounding box cache, entries by spec hash (only loaded during startup)
+	bool							m_boundsCacheExists = false;		///< Was the bounding box cache file found (by resolveTargetModels())?
+	bool							m_boundsCacheChanged = false;		///< Were entries for specs no longer in use dropped from the cache?
+	Array<UnsizedTargetModel>		m_unsizedTargetModels;
+
+	// Decal/explosion textures, decoded on a worker and uploaded on the main thread at startup
+	shared_ptr<Image>				m_decalImage;
+	shared_ptr<Image>				m_explosionImage;
+	shared_ptr<Texture>				m_decalTexture;
+	shared_ptr<Texture>				m_explosionTexture;
 
 	/** Used for visualizing history of frame times. Temporary, awaiting a G3D built-in that does this directly with a texture. */
-	Queue<float>                    m_frameDurationQueue;				///< Queue for history of frrame times
+	RollingFrameStats				m_frameStats = RollingFrameStats(MAX_HISTORY_TIMING_FRAMES);	///< Measured (present to present) frame durations over the last few frames
+	SessionFrameStats				m_sessionFrameStats;				///< Measured frame durations during the current session's task (logged at the end of the session)
+	RealTime						m_lastPresentTime = 0.0;			///< Time the last frame was presented
+	int								m_traceFramesLeft = 0;				///< Frames left in the trace being recorded
+
+	/** Key/button transition picked up by the late latch (replayed on the next frame) */
+	struct LateLatchKey {
+		GKey	key;
+		bool	pressed;
+	};
+	Array<LateLatchKey>				m_lateLatchKeys;					///< Transitions from the last late latch
+	RealTime						m_inputSampleTime = 0.0;			///< Time of the last input sample (for the input to submit time)
+	int								m_weaponSurfaceStart = 0;			///< Index of the weapon's surfaces in m_posed3D (so the late latch can re-pose them)
+	int								m_weaponSurfaceCount = 0;
 
 	/** Coordinate frame of the weapon, updated in onPose() */
 	CFrame                          m_weaponFrame;						///< Frame for the weapon
 
 	/** Used to detect GUI changes to m_reticleIndex */
-	int                             m_lastReticleLoaded = -1;			///< Last loaded reticle (used for change detection)
+	int                             m_lastReticleLoaded = -1;			///< Current reticle index (used for change detection)
 	float							m_debugMenuHeight = 0.0f;			///< Height of the debug menu when in developer mode
     GuiPane*                        m_currentUserPane;					///< Current user information pane
 
@@ -160,6 +211,32 @@ protected:
 	String							m_defaultScene = "FPSci Simple Hallway";	// Default scene to load
 
 	shared_ptr<PythonLogger>		m_pyLogger = nullptr;
+	SystemConfig					m_sysConfig;						///< System config (loaded once on init)
+	shared_ptr<SessionPrefetcher>	m_prefetch;							///< Loads the next session's assets while the current session wraps up
+	AssetCache<GFont>				m_fontCache = AssetCache<GFont>([](const String& filename) { return GFont::fromFile(filename); });	///< Session fonts (by data file name)
+	AssetCache<Sound>				m_soundCache = AssetCache<Sound>([](const String& filename) { return Sound::create(filename); });	///< Session sounds (by data file name)
+	shared_ptr<JobPool>				m_jobPool;							///< Worker threads for parallel target updates
+	TargetPool						m_targetPool;						///< Destroyed targets kept for reuse by the spawn methods
+	TargetBVH						m_targetBVH;						///< Target bounding spheres for hit testing in fire() (built in onPose())
+	bool							m_targetBVHDirty = true;			///< Targets were spawned/destroyed since m_targetBVH was built
+	Array<TargetBVH::Candidate>		m_hitCandidates;					///< Targets along the fire ray (reused across shots)
+	shared_ptr<HeadlessDriver>		m_headless;							///< Scripted input/fixed timestep driver (only in headless mode)
+	shared_ptr<AimAgent>			m_aimAgent;							///< Synthetic player (only in headless mode)
+
+	static constexpr RealTime		m_maxSimLag = 0.25;					///< Most real time simulated in one frame (only longer hitches drop time)
+	RealTime						m_simAccumulator = 0.0;				///< Real time not yet simulated (fixed timestep mode)
+	float							m_simInterpolation = 1.0f;			///< Position of this frame between the last two simulation steps (for posing)
+	Array<CFrame>					m_simulatedFrames;					///< Simulated target frames saved while posing interpolated frames
+	shared_ptr<SimulationThread>	m_simThread;						///< High rate target simulation thread (when enabled for the session)
+
+	shared_ptr<FrameArena>			m_frameArena = FrameArena::create();	///< Scratch memory for per-frame temporaries (reset at the start of each frame)
+	uint64							m_frameStartAllocations = 0;		///< Main thread heap allocation count at the start of the frame
+	uint64							m_frameAllocations = 0;				///< Main thread heap allocations made during the last frame
+	uint64							m_frameIndex = 0;					///< Frames run since startup (logged w/ the frame info)
+	FramePacer						m_framePacer;						///< Frame wait (sleep/spin) and wake-up error histogram (per session)
+	FrameScheduler					m_frameScheduler;					///< Predicts the frame cost from the recent per-phase costs
+	RealTime						m_frameDeadline = 0.0;				///< Time the current frame should be presented by (when jitFrameStart is set)
+	RealTime						m_predictedFrameCost = 0.0;			///< Predicted time from the end of the last wait to the buffer swap
 
 	/** When m_displayLagFrames > 0, 3D frames are delayed in this queue */
 	Array<shared_ptr<Framebuffer>>  m_ldrDelayBufferQueue;
@@ -171,7 +248,32 @@ protected:
 	/** Called from onInit */
 	void makeGUI();
 	void updateControls();
-	void loadModels();
+	/** Decode the decal and explosion textures from their (resolved) files (safe to call from a worker thread) */
+	void decodeModelImages(const String& decalFile, const String& explosionFile);
+	/** Create the decal and explosion textures from the decoded images (needs the GL context) */
+	void uploadModelTextures();
+	/** Replace the materials of a model w/ a (lambertian) texture */
+	static void setModelTexture(const shared_ptr<ArticulatedModel>& model, const shared_ptr<Texture>& texture);
+	/** Load the weapon, bullet and decal models */
+	void loadWeaponModels();
+	/** Setup the target/explosion model specifications and resolve the target model files (System::findDataFile() isn't thread safe) */
+	void resolveTargetModels();
+	/** Size the target models found in the bounding box cache (safe to call from a worker thread) */
+	void prepareTargetModels();
+	/** Set the (1m across) model specification for a target id from its model's bounding box extent */
+	void setTargetModelExtent(const String& id, Any spec, const Vector3& extent);
+	/** Size the target models missing from the bounding box cache (needs the GL context) and create the target poses */
+	void loadTargetModels();
+	/** Get the model scale index for a target of a given size */
+	int modelScaleIndex(float scale) const;
+	/** Get the target model for an id at a scale index, creating it if needed */
+	const shared_ptr<ArticulatedModel>& targetModel(const String& id, int scaleIdx);
+	/** Get the explosion model at a scale index, creating it if needed */
+	const shared_ptr<ArticulatedModel>& explosionModel(int scaleIdx);
+	/** Create the target/explosion models the current session can use */
+	void prepareSessionModels();
+	/** Set a target's (colored) material using a cached pose */
+	void setTargetMaterial(const shared_ptr<TargetEntity>& target, const Color3& color);
 	void updateUser(void);
     void updateUserGUI();
 
@@ -183,13 +285,16 @@ public:
 	shared_ptr<GFont>               outputFont;						///< Font used for output
 	shared_ptr<GFont>               hudFont;						///< Font used in HUD
 	Array<shared_ptr<GFont>>		floatingCombatText;				///< Floating combat text array
-	shared_ptr<Texture>             reticleTexture;					///< Texture used for reticle
+	shared_ptr<ReticleAtlas>		reticleAtlas;					///< All reticles (drawn by index)
 	shared_ptr<Texture>             hudTexture;						///< Texture used for HUD
 	shared_ptr<GuiTheme>			theme;	
 	bool                            emergencyTurbo = false;			///< Lower rendering quality to improve performance
 
 	App(const GApp::Settings& settings = GApp::Settings());
 
+	/** Worker threads for parallel (and background) jobs */
+	const shared_ptr<JobPool>& jobPool() const { return m_jobPool; }
+
 	/** Array of all targets in the scene */
 	Array<shared_ptr<TargetEntity>> targetArray;					///< Array of drawn targets
 	Array<Projectile>                projectileArray;				///< Arrray of drawn projectiles
@@ -222,6 +327,10 @@ public:
 	void showRenderControls();
 	/** Show the weapon controls */
 	void showWeaponControls();
+	/** Benchmark player collision against the current scene (results are written to the log) */
+	void runCollisionBenchmark();
+	/** Start/advance prefetching the next session's assets once the current session is wrapping up */
+	void updatePrefetch();
 	/** Save scene w/ updated player position */
 	void exportScene();
 
@@ -298,6 +407,9 @@ public:
 	String getDropDownUserId(void);
 	shared_ptr<UserConfig> getCurrUser(void);
 
+	const FramePacer& framePacer() const { return m_framePacer; }
+	const SessionFrameStats& sessionFrameStats() const { return m_sessionFrameStats; }
+
     void quitRequest();
 	   
 	/** opens the user settings window */
@@ -330,6 +442,24 @@ public:
 	virtual void onUserInput(UserInput* ui) override;
 	virtual void onCleanup() override;
     virtual void oneFrame() override;
+
+	/** Run one fixed timestep of input and simulation w/o rendering (headless mode) */
+	void oneHeadlessFrame();
+
+	/** Wait out the rest of the frame (using the session's frame pacing mode) */
+	void waitForFrame();
+
+	/** Pose the weapon model (at the current camera frame) */
+	void poseWeapon(Array<shared_ptr<Surface>>& surface);
+	/** Resample mouse input and update the camera/weapon view right before rendering (see RenderConfig::lateLatchView) */
+	void lateLatchView();
+
+	/** Start recording a trace of the next traceFrames frames (see TraceRecorder) */
+	void startTrace();
+	/** Stop recording and write the trace to the results directory */
+	void stopTrace();
+	/** Start/stop the trace recording at the start of each frame */
+	void updateTrace();
 	
 	// hardware setting
 	struct ScreenSetting
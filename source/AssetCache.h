@@ -0,0 +1,68 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <functional>
+
+/** Keyed cache of loaded assets (fonts, sounds, ...) so switching between sessions doesn't reload them from disk.
+	Assets are reference counted through their shared_ptrs, an entry is "unused" when the cache holds the only reference.
+	prune() drops the least recently used of the unused entries once there are more than maxUnused of them. */
+template <class T>
+class AssetCache {
+public:
+	typedef std::function<shared_ptr<T>(const String& filename)> Loader;
+
+protected:
+	struct Entry {
+		shared_ptr<T>		asset;
+		uint64				lastUse = 0;			///< Value of m_useCounter when this entry was last returned
+	};
+
+	Table<String, Entry>	m_entries;
+	Loader					m_loader;
+	uint64					m_useCounter = 0;
+	int						m_maxUnused;
+
+public:
+	/** The loader is called (w/ the resolved data file) on a miss */
+	AssetCache(const Loader& loader, int maxUnused = 4) : m_loader(loader), m_maxUnused(maxUnused) {}
+
+	/** Get the asset for a data file name, loading it on a miss (only misses touch the disk).
+		The entry is only added once the load succeeds, so a failed load is retried on the next get(). */
+	shared_ptr<T> get(const String& name) {
+		Entry* entry = m_entries.getPointer(name);
+		if (isNull(entry)) {
+			Entry loaded;
+			loaded.asset = m_loader(System::findDataFile(name));
+			entry = &m_entries.getCreate(name);
+			*entry = loaded;
+		}
+		entry->lastUse = ++m_useCounter;
+		return entry->asset;
+	}
+
+	bool contains(const String& name) const {
+		return m_entries.containsKey(name);
+	}
+
+	/** Number of references to the asset outside of this cache (0 if it isn't loaded) */
+	int refCount(const String& name) const {
+		const Entry* entry = m_entries.getPointer(name);
+		return isNull(entry) ? 0 : int(entry->asset.use_count()) - 1;
+	}
+
+	/** Drop the least recently used unused assets until at most maxUnused remain */
+	void prune() {
+		Array<String> unused;
+		for (const typename Table<String, Entry>::Entry& e : m_entries) {
+			if (e.value.asset.use_count() == 1) unused.append(e.key);
+		}
+		if (unused.size() <= m_maxUnused) return;
+		unused.sort([this](const String& a, const String& b) { return m_entries[a].lastUse < m_entries[b].lastUse; });
+		for (int i = 0; i < unused.size() - m_maxUnused; i++) {
+			m_entries.remove(unused[i]);
+		}
+	}
+
+	int size() const { return m_entries.size(); }
+
+	void clear() { m_entries.clear(); }
+};
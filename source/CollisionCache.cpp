@@ -0,0 +1,159 @@
+#include "CollisionCache.h"
+
+/** FNV-1a hash of bytes (continuing from hash) */
+static uint64 hashBytes(const void* data, size_t size, uint64 hash = 14695981039346656037ULL) {
+	const uint8* bytes = static_cast<const uint8*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+/** Hash a file's path, size and modification time (cheaper than hashing large model files) */
+static uint64 hashFileStamp(const String& path, uint64 hash) {
+	hash = hashBytes(path.c_str(), path.size(), hash);
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes)) {
+		hash = hashBytes(&attributes.nFileSizeHigh, sizeof(attributes.nFileSizeHigh), hash);
+		hash = hashBytes(&attributes.nFileSizeLow, sizeof(attributes.nFileSizeLow), hash);
+		hash = hashBytes(&attributes.ftLastWriteTime, sizeof(attributes.ftLastWriteTime), hash);
+	}
+	return hash;
+}
+
+uint64 CollisionCache::fileStamp(const String& path) {
+	return hashFileStamp(path, 14695981039346656037ULL);
+}
+
+uint64 CollisionCache::stringHash(const String& s) {
+	return hashBytes(s.c_str(), s.size());
+}
+
+Array<String> CollisionCache::modelFiles(const Any& sceneAny) {
+	Array<String> files;
+	if (sceneAny.containsKey("models")) {
+		for (const Table<String, Any>::Entry& model : sceneAny["models"].table()) {
+			if (model.value.type() == Any::TABLE && model.value.containsKey("filename")) {
+				files.append(model.value["filename"].resolveStringAsFilename());
+			}
+		}
+	}
+	return files;
+}
+
+uint64 CollisionCache::sceneKey(const String& sceneFile, const Any& sceneAny) {
+	const String contents = readWholeFile(sceneFile);
+	uint64 hash = hashBytes(contents.c_str(), contents.size());
+	for (const String& file : modelFiles(sceneAny)) {
+		hash = hashFileStamp(file, hash);
+	}
+	return hash;
+}
+
+String CollisionCache::filename(const String& directory, uint64 key) {
+	return FilePath::concat(directory, format("%016llx.collision", (unsigned long long)key));
+}
+
+bool CollisionCache::load(const String& directory, uint64 key, Array<Tri>& triArray, CPUVertexArray& vertexArray) {
+	const String path = filename(directory, key);
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	bool valid = false;
+	LARGE_INTEGER size;
+	HANDLE mapping = nullptr;
+	const uint8* data = nullptr;
+	if (GetFileSizeEx(file, &size) && size.QuadPart >= 4 * sizeof(uint32) + sizeof(uint64)) {
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (notNull(mapping)) {
+			data = static_cast<const uint8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		}
+	}
+
+	if (notNull(data)) {
+		// Header is magic, version, key, triangle count (then a pad word so the triangles are 8 byte aligned)
+		const uint32* header = reinterpret_cast<const uint32*>(data);
+		const uint64 fileKey = *reinterpret_cast<const uint64*>(data + 2 * sizeof(uint32));
+		const uint32 triCount = header[4];
+		const size_t headerSize = 4 * sizeof(uint32) + sizeof(uint64);
+		valid = (header[0] == Magic) && (header[1] == Version) && (fileKey == key) &&
+			(size_t(size.QuadPart) == headerSize + size_t(triCount) * sizeof(CachedTri));
+
+		if (valid) {
+			fromCachedTris(reinterpret_cast<const CachedTri*>(data + headerSize), triCount, triArray, vertexArray);
+		}
+		UnmapViewOfFile(data);
+	}
+	if (notNull(mapping)) {
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+
+	if (!valid) {
+		logPrintf("Ignoring invalid collision cache file %s\n", path.c_str());
+	}
+	return valid;
+}
+
+void CollisionCache::toCachedTris(const Array<Tri>& triArray, const CPUVertexArray& vertexArray, Array<CachedTri>& tris) {
+	tris.resize(triArray.size());
+	for (int t = 0; t < triArray.size(); t++) {
+		for (int v = 0; v < 3; v++) {
+			const Point3& p = triArray[t].position(vertexArray, v);
+			tris[t].position[v][0] = p.x;
+			tris[t].position[v][1] = p.y;
+			tris[t].position[v][2] = p.z;
+		}
+		tris[t].twoSided = triArray[t].twoSided() ? 1 : 0;
+	}
+}
+
+void CollisionCache::fromCachedTris(const CachedTri* tris, uint32 triCount, Array<Tri>& triArray, CPUVertexArray& vertexArray) {
+	vertexArray.vertex.resize(3 * triCount);
+	triArray.fastClear();
+	triArray.reserve(triCount);
+	for (uint32 t = 0; t < triCount; t++) {
+		const Point3 p[3] = {
+			Point3(tris[t].position[0][0], tris[t].position[0][1], tris[t].position[0][2]),
+			Point3(tris[t].position[1][0], tris[t].position[1][1], tris[t].position[1][2]),
+			Point3(tris[t].position[2][0], tris[t].position[2][1], tris[t].position[2][2])
+		};
+		const Vector3 n = (p[1] - p[0]).cross(p[2] - p[0]).directionOrZero();
+		for (int v = 0; v < 3; v++) {
+			CPUVertexArray::Vertex& vertex = vertexArray.vertex[3 * t + v];
+			vertex.position = p[v];
+			vertex.normal = n;
+		}
+	}
+	for (uint32 t = 0; t < triCount; t++) {
+		triArray.append(Tri(3 * t, 3 * t + 1, 3 * t + 2, vertexArray, nullptr, tris[t].twoSided != 0));
+	}
+}
+
+void CollisionCache::toCollisionGeometry(Array<Tri>& triArray, CPUVertexArray& vertexArray) {
+	Array<CachedTri> tris;
+	toCachedTris(triArray, vertexArray, tris);
+	fromCachedTris(tris.getCArray(), uint32(tris.size()), triArray, vertexArray);
+}
+
+void CollisionCache::save(const String& directory, uint64 key, const Array<Tri>& triArray, const CPUVertexArray& vertexArray) {
+	if (!FileSystem::exists(directory)) {
+		FileSystem::createDirectory(directory);
+	}
+	BinaryOutput out(filename(directory, key), G3D_LITTLE_ENDIAN);
+	out.writeUInt32(Magic);
+	out.writeUInt32(Version);
+	out.writeUInt64(key);
+	out.writeUInt32(uint32(triArray.size()));
+	out.writeUInt32(0);
+	for (const Tri& tri : triArray) {
+		for (int v = 0; v < 3; v++) {
+			const Point3& p = tri.position(vertexArray, v);
+			out.writeFloat32(p.x);
+			out.writeFloat32(p.y);
+			out.writeFloat32(p.z);
+		}
+		out.writeUInt32(tri.twoSided() ? 1 : 0);
+	}
+	out.commit();
+}
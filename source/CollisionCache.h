@@ -0,0 +1,45 @@
+#pragma once
+#include <G3D/G3D.h>
+
+/** On-disk cache of scene collision geometry, so scene loads can skip posing the static entities and extracting their triangles.
+	Files are keyed by a hash of the scene file (contents) and the model files it references (size and modification time),
+	so editing either one misses the cache. Cache files are memory mapped when read. */
+class CollisionCache {
+protected:
+	static const uint32 Magic = 0x43435046;			///< "FPCC"
+	static const uint32 Version = 1;
+
+	/** Triangle record (in the file) */
+	struct CachedTri {
+		float	position[3][3];
+		uint32	twoSided;
+	};
+
+	static String filename(const String& directory, uint64 key);
+
+	static void toCachedTris(const Array<Tri>& triArray, const CPUVertexArray& vertexArray, Array<CachedTri>& tris);
+	static void fromCachedTris(const CachedTri* tris, uint32 triCount, Array<Tri>& triArray, CPUVertexArray& vertexArray);
+
+public:
+	/** Model files referenced by the "models" in a scene Any */
+	static Array<String> modelFiles(const Any& sceneAny);
+
+	/** Hash of a file's path, size and modification time (changes whenever the file is edited) */
+	static uint64 fileStamp(const String& path);
+
+	/** Hash of a string (stable across runs, for on-disk cache keys) */
+	static uint64 stringHash(const String& s);
+
+	/** Cache key for a scene (from its file and the "models" in its (loaded) Any) */
+	static uint64 sceneKey(const String& sceneFile, const Any& sceneAny);
+
+	/** Load the collision triangles for key from directory, returns false if there is no (valid) cache file */
+	static bool load(const String& directory, uint64 key, Array<Tri>& triArray, CPUVertexArray& vertexArray);
+
+	/** Convert triangles to the form load() produces (unshared vertices w/ face normals, no materials), so collision
+		geometry built from the scene matches geometry loaded from the cache exactly (i.e. ray queries never alpha test) */
+	static void toCollisionGeometry(Array<Tri>& triArray, CPUVertexArray& vertexArray);
+
+	/** Save the collision triangles for key to directory */
+	static void save(const String& directory, uint64 key, const Array<Tri>& triArray, const CPUVertexArray& vertexArray);
+};
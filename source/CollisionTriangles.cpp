@@ -0,0 +1,210 @@
+#include "CollisionTriangles.h"
+#include "PhysicsScene.h"
+
+#if defined(__AVX__)
+#	include <immintrin.h>
+#	define COLLISION_SIMD_WIDTH 8
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define COLLISION_SIMD_WIDTH 4
+#else
+#	define COLLISION_SIMD_WIDTH 1
+#endif
+
+/** Slack added to the sphere radius so rounding in the cull can't reject a triangle the exact test would hit */
+static const float CullEpsilon = 1e-4f;
+
+int CollisionTriangles::simdWidth() {
+	return COLLISION_SIMD_WIDTH;
+}
+
+void CollisionTriangles::clear() {
+	m_triangles.fastClear();
+	for (int l = 0; l < LANE_COUNT; l++) {
+		m_lanes[l].fastClear();
+	}
+}
+
+void CollisionTriangles::set(const Array<Tri>& tris, const CPUVertexArray& cpuVertexArray) {
+	clear();
+	const int padded = ((tris.size() + BatchSize - 1) / BatchSize) * BatchSize;
+	for (int l = 0; l < LANE_COUNT; l++) {
+		m_lanes[l].resize(padded, false);
+	}
+
+	for (int i = 0; i < tris.size(); i++) {
+		const Tri& tri = tris[i];
+		const Triangle triangle(tri.position(cpuVertexArray, 0), tri.position(cpuVertexArray, 1), tri.position(cpuVertexArray, 2));
+		m_triangles.append(triangle);
+
+		const Vector3& n = triangle.normal();
+		m_lanes[NX][i] = n.x;
+		m_lanes[NY][i] = n.y;
+		m_lanes[NZ][i] = n.z;
+		m_lanes[PD][i] = n.dot(triangle.vertex(0));
+		AABox bounds;
+		triangle.getBounds(bounds);
+		for (int a = 0; a < 3; a++) {
+			m_lanes[MINX + a][i] = bounds.low()[a];
+			m_lanes[MAXX + a][i] = bounds.high()[a];
+		}
+	}
+
+	// Padding lanes have empty bounds (so they never pass the cull)
+	for (int i = tris.size(); i < padded; i++) {
+		m_lanes[NX][i] = m_lanes[NY][i] = m_lanes[NZ][i] = m_lanes[PD][i] = 0.0f;
+		for (int a = 0; a < 3; a++) {
+			m_lanes[MINX + a][i] = finf();
+			m_lanes[MAXX + a][i] = -finf();
+		}
+	}
+}
+
+// The cull keeps a triangle when its bounds overlap the bounds of the swept sphere, unless the sphere stays entirely on one side
+// of the triangle's plane for the whole move (the signed plane distance is linear in time, so checking the ends is enough).
+// Rejection is written so a NaN (degenerate triangle) normal keeps the triangle.
+
+void CollisionTriangles::sweptSphereCandidatesScalar(const Sphere& sphere, const Vector3& velocity, float time, Array<int>& candidates) const {
+	const float r = sphere.radius + CullEpsilon;
+	const Point3& c = sphere.center;
+	const Vector3 move = velocity * time;
+	const Point3 lo = c.min(c + move) - Vector3(r, r, r);
+	const Point3 hi = c.max(c + move) + Vector3(r, r, r);
+	for (int i = 0; i < m_triangles.size(); i++) {
+		if (m_lanes[MINX][i] > hi.x || m_lanes[MAXX][i] < lo.x ||
+			m_lanes[MINY][i] > hi.y || m_lanes[MAXY][i] < lo.y ||
+			m_lanes[MINZ][i] > hi.z || m_lanes[MAXZ][i] < lo.z) continue;
+		const Vector3 n(m_lanes[NX][i], m_lanes[NY][i], m_lanes[NZ][i]);
+		const float d0 = n.dot(c) - m_lanes[PD][i];
+		const float d1 = d0 + n.dot(move);
+		if (min(d0, d1) > r || max(d0, d1) < -r) continue;
+		candidates.append(i);
+	}
+}
+
+void CollisionTriangles::sweptSphereCandidates(const Sphere& sphere, const Vector3& velocity, float time, Array<int>& candidates) const {
+#if COLLISION_SIMD_WIDTH == 1
+	sweptSphereCandidatesScalar(sphere, velocity, time, candidates);
+#else
+	const float r = sphere.radius + CullEpsilon;
+	const Point3& c = sphere.center;
+	const Vector3 move = velocity * time;
+	const Point3 lo = c.min(c + move) - Vector3(r, r, r);
+	const Point3 hi = c.max(c + move) + Vector3(r, r, r);
+	const int count = m_triangles.size();
+	const int padded = m_lanes[NX].size();
+
+#	if COLLISION_SIMD_WIDTH == 8
+	const __m256 cx = _mm256_set1_ps(c.x), cy = _mm256_set1_ps(c.y), cz = _mm256_set1_ps(c.z);
+	const __m256 mx = _mm256_set1_ps(move.x), my = _mm256_set1_ps(move.y), mz = _mm256_set1_ps(move.z);
+	const __m256 rad = _mm256_set1_ps(r), negRad = _mm256_set1_ps(-r);
+	const __m256 lox = _mm256_set1_ps(lo.x), loy = _mm256_set1_ps(lo.y), loz = _mm256_set1_ps(lo.z);
+	const __m256 hix = _mm256_set1_ps(hi.x), hiy = _mm256_set1_ps(hi.y), hiz = _mm256_set1_ps(hi.z);
+	for (int i = 0; i < padded; i += 8) {
+		const __m256 nx = _mm256_loadu_ps(&m_lanes[NX][i]);
+		const __m256 ny = _mm256_loadu_ps(&m_lanes[NY][i]);
+		const __m256 nz = _mm256_loadu_ps(&m_lanes[NZ][i]);
+		const __m256 d0 = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)), _mm256_mul_ps(nz, cz)), _mm256_loadu_ps(&m_lanes[PD][i]));
+		const __m256 d1 = _mm256_add_ps(d0, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, mx), _mm256_mul_ps(ny, my)), _mm256_mul_ps(nz, mz)));
+		__m256 reject = _mm256_or_ps(_mm256_cmp_ps(_mm256_min_ps(d0, d1), rad, _CMP_GT_OQ), _mm256_cmp_ps(_mm256_max_ps(d0, d1), negRad, _CMP_LT_OQ));
+		reject = _mm256_or_ps(reject, _mm256_or_ps(_mm256_cmp_ps(_mm256_loadu_ps(&m_lanes[MINX][i]), hix, _CMP_GT_OQ), _mm256_cmp_ps(_mm256_loadu_ps(&m_lanes[MAXX][i]), lox, _CMP_LT_OQ)));
+		reject = _mm256_or_ps(reject, _mm256_or_ps(_mm256_cmp_ps(_mm256_loadu_ps(&m_lanes[MINY][i]), hiy, _CMP_GT_OQ), _mm256_cmp_ps(_mm256_loadu_ps(&m_lanes[MAXY][i]), loy, _CMP_LT_OQ)));
+		reject = _mm256_or_ps(reject, _mm256_or_ps(_mm256_cmp_ps(_mm256_loadu_ps(&m_lanes[MINZ][i]), hiz, _CMP_GT_OQ), _mm256_cmp_ps(_mm256_loadu_ps(&m_lanes[MAXZ][i]), loz, _CMP_LT_OQ)));
+		int keep = ~_mm256_movemask_ps(reject) & 0xFF;
+#	else
+	const __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), cz = _mm_set1_ps(c.z);
+	const __m128 mx = _mm_set1_ps(move.x), my = _mm_set1_ps(move.y), mz = _mm_set1_ps(move.z);
+	const __m128 rad = _mm_set1_ps(r), negRad = _mm_set1_ps(-r);
+	const __m128 lox = _mm_set1_ps(lo.x), loy = _mm_set1_ps(lo.y), loz = _mm_set1_ps(lo.z);
+	const __m128 hix = _mm_set1_ps(hi.x), hiy = _mm_set1_ps(hi.y), hiz = _mm_set1_ps(hi.z);
+	for (int i = 0; i < padded; i += 4) {
+		const __m128 nx = _mm_loadu_ps(&m_lanes[NX][i]);
+		const __m128 ny = _mm_loadu_ps(&m_lanes[NY][i]);
+		const __m128 nz = _mm_loadu_ps(&m_lanes[NZ][i]);
+		const __m128 d0 = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_mul_ps(nz, cz)), _mm_loadu_ps(&m_lanes[PD][i]));
+		const __m128 d1 = _mm_add_ps(d0, _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, mx), _mm_mul_ps(ny, my)), _mm_mul_ps(nz, mz)));
+		__m128 reject = _mm_or_ps(_mm_cmpgt_ps(_mm_min_ps(d0, d1), rad), _mm_cmplt_ps(_mm_max_ps(d0, d1), negRad));
+		reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmpgt_ps(_mm_loadu_ps(&m_lanes[MINX][i]), hix), _mm_cmplt_ps(_mm_loadu_ps(&m_lanes[MAXX][i]), lox)));
+		reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmpgt_ps(_mm_loadu_ps(&m_lanes[MINY][i]), hiy), _mm_cmplt_ps(_mm_loadu_ps(&m_lanes[MAXY][i]), loy)));
+		reject = _mm_or_ps(reject, _mm_or_ps(_mm_cmpgt_ps(_mm_loadu_ps(&m_lanes[MINZ][i]), hiz), _mm_cmplt_ps(_mm_loadu_ps(&m_lanes[MAXZ][i]), loz)));
+		int keep = ~_mm_movemask_ps(reject) & 0xF;
+#	endif
+		// Padding lanes always reject (empty bounds), the count check is just for safety
+		for (int b = 0; keep != 0; b++, keep >>= 1) {
+			if ((keep & 1) && (i + b < count)) {
+				candidates.append(i + b);
+			}
+		}
+	}
+#endif
+}
+
+/** Earliest collision time of the sphere w/ the candidate triangles (finf() if there is none before maxTime) */
+static float firstCollisionTime(const CollisionTriangles& tris, const Array<int>* candidates, const Sphere& sphere, const Vector3& velocity, float maxTime) {
+	float first = maxTime;
+	Vector3 C;
+	const int count = notNull(candidates) ? candidates->size() : tris.size();
+	for (int i = 0; i < count; i++) {
+		const Triangle& triangle = tris[notNull(candidates) ? (*candidates)[i] : i];
+		first = min(first, CollisionDetection::collisionTimeForMovingSphereFixedTriangle(sphere, velocity, triangle, C));
+	}
+	return (first < maxTime) ? first : finf();
+}
+
+String CollisionTriangles::benchmark(const PhysicsScene* scene, const Point3& center, float radius, float sphereRadius, int samples) {
+	static const int repeats = 20;
+	static const float speed = 10.0f;			// Faster than the player moves, to test a longer sweep
+	static const float time = 1.0f / 60.0f;
+	static const float padding = 1.0f;			// Matches the player's collision cache padding
+
+	Random rng(0xC0111DE, false);
+	CollisionTriangles tris;
+	Array<Tri> query;
+	Array<int> candidates;
+	RealTime serialTime = 0.0, batchedTime = 0.0;
+	int64 triangleCount = 0, candidateCount = 0;
+	int hits = 0, mismatches = 0;
+	float checksum = 0.0f;
+
+	for (int s = 0; s < samples; s++) {
+		const Point3 p = center + Vector3(rng.uniform(-radius, radius), rng.uniform(-1.0f, 1.0f), rng.uniform(-radius, radius));
+		const Sphere sphere(p, sphereRadius);
+		const Vector3 velocity = Vector3::random(rng) * speed;
+
+		// Query the triangles the same way the player's collision cache does (outside of the timing)
+		query.fastClear();
+		scene->staticIntersectSphere(Sphere(p, sphereRadius + speed * time + padding), query);
+		tris.set(query, scene->vertexArrayOfCollisionTree());
+		triangleCount += tris.size();
+
+		float serial = 0.0f, batched = 0.0f;
+		RealTime start = System::time();
+		for (int r = 0; r < repeats; r++) {
+			serial = firstCollisionTime(tris, nullptr, sphere, velocity, time);
+		}
+		serialTime += System::time() - start;
+
+		start = System::time();
+		for (int r = 0; r < repeats; r++) {
+			candidates.fastClear();
+			tris.sweptSphereCandidates(sphere, velocity, time, candidates);
+			batched = firstCollisionTime(tris, &candidates, sphere, velocity, time);
+		}
+		batchedTime += System::time() - start;
+		candidateCount += candidates.size();
+
+		if (serial < finf()) {
+			hits++;
+			checksum += serial;
+		}
+		if (serial != batched) {
+			mismatches++;
+		}
+	}
+
+	const double tests = double(samples) * repeats;
+	return format("Collision benchmark (%d samples, SIMD width %d): %.1f triangles/%.1f candidates per test, %d hits, %d mismatches (checksum %f)\n"
+		"  serial: %.3f us/test, batched: %.3f us/test (%.2fx)",
+		samples, simdWidth(), double(triangleCount) / max(samples, 1), double(candidateCount) / max(samples, 1), hits, mismatches, checksum,
+		1e6 * serialTime / tests, 1e6 * batchedTime / tests, serialTime / max(batchedTime, 1e-9));
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <G3D/G3D.h>
+
+class PhysicsScene;
+
+/** World-space static triangles for swept sphere collision, w/ a structure of arrays copy of their planes and bounds.
+	sweptSphereCandidates() culls the triangles in batches (8 wide w/ AVX, 4 wide w/ SSE, scalar otherwise) against the
+	swept sphere. Culling is conservative, the exact (G3D) collision test is only run for the triangles that survive it. */
+class CollisionTriangles {
+protected:
+	/** Per triangle values stored in m_lanes */
+	enum Lane { NX, NY, NZ, PD, MINX, MINY, MINZ, MAXX, MAXY, MAXZ, LANE_COUNT };
+
+	static const int		BatchSize = 8;						///< Lanes are padded to a multiple of this
+
+	Array<Triangle>			m_triangles;
+	Array<float>			m_lanes[LANE_COUNT];				///< Plane (normal, distance) and bounds of each triangle (padded w/ empty bounds)
+
+public:
+	/** Set the triangles from collision tree tris */
+	void set(const Array<Tri>& tris, const CPUVertexArray& cpuVertexArray);
+
+	void clear();
+
+	int size() const { return m_triangles.size(); }
+	const Triangle& operator[](int i) const { return m_triangles[i]; }
+
+	/** Append the indices of the triangles the sphere could hit moving along velocity for time (in seconds).
+		This may include triangles that are not hit, but never leaves out one that is. */
+	void sweptSphereCandidates(const Sphere& sphere, const Vector3& velocity, float time, Array<int>& candidates) const;
+
+	/** Scalar version of sweptSphereCandidates() (for reference/benchmarking) */
+	void sweptSphereCandidatesScalar(const Sphere& sphere, const Vector3& velocity, float time, Array<int>& candidates) const;
+
+	/** Batch width used by sweptSphereCandidates() (1 when built w/o SIMD support) */
+	static int simdWidth();
+
+	/** Time the serial (exact test on every triangle) and batched (cull then exact test) swept sphere collision against the
+		scene's collision geometry, for samples random moves within radius of center. Returns a summary of the results. */
+	static String benchmark(const PhysicsScene* scene, const Point3& center, float radius, float sphereRadius, int samples);
+};
@@ -3,6 +3,48 @@
 #include <G3D/G3D.h>
 #include "TargetEntity.h"
 
+/** Synthetic (aiming) player used for automated runs in headless mode */
+class AimAgentConfig {
+public:
+	bool	enable = false;						///< Replace the player w/ the synthetic aiming agent
+	String	model = "track";					///< Aiming model, "track" (proportional tracking) or "flick" (flick to target, then track)
+	float	reactionTime = 0.2f;				///< Delay (in seconds) between a target appearing/being selected and the agent responding
+	float	trackingGain = 10.0f;				///< Proportional tracking gain (turn rate per unit of angular error, in 1/s)
+	float	maxTurnRate = 720.0f;				///< Maximum turn rate (in degrees/s)
+	float	aimNoise = 2.0f;					///< Standard deviation of noise added to the turn rate (in degrees/s)
+	float	flickDuration = 0.1f;				///< Time to complete a flick (in seconds)
+	float	flickError = 1.0f;					///< Standard deviation of the flick end point error (in degrees)
+	float	fireAngle = 1.0f;					///< Fire when the aim is within this angle (in degrees) of the target
+
+	void load(AnyTableReader reader) {
+		reader.getIfPresent("enable", enable);
+		reader.getIfPresent("model", model);
+		if (model != "track" && model != "flick") {
+			throw format("Aim agent \"model\" must be \"track\" or \"flick\" (provided \"%s\")!", model.c_str());
+		}
+		reader.getIfPresent("reactionTime", reactionTime);
+		reader.getIfPresent("trackingGain", trackingGain);
+		reader.getIfPresent("maxTurnRate", maxTurnRate);
+		reader.getIfPresent("aimNoise", aimNoise);
+		reader.getIfPresent("flickDuration", flickDuration);
+		reader.getIfPresent("flickError", flickError);
+		reader.getIfPresent("fireAngle", fireAngle);
+	}
+
+	Any addToAny(Any a) const {
+		a["enable"] = enable;
+		a["model"] = model;
+		a["reactionTime"] = reactionTime;
+		a["trackingGain"] = trackingGain;
+		a["maxTurnRate"] = maxTurnRate;
+		a["aimNoise"] = aimNoise;
+		a["flickDuration"] = flickDuration;
+		a["flickError"] = flickError;
+		a["fireAngle"] = fireAngle;
+		return a;
+	}
+};
+
 /** Configure how the application should start */
 class StartupConfig {
 public:
@@ -12,6 +54,16 @@ public:
     String	experimentConfigPath = "";			///< Optional path to an experiment config file (if "experimentconfig.Any" will not be this file)
     String	userConfigPath = "";				///< Optional path to a user config file (if "userconfig.Any" will not be this file)
     bool	audioEnable = true;					///< Audio on/off
+	String	collisionCachePath = "collisionCache/";	///< Directory for cached scene collision geometry (empty to disable)
+	int		traceFrames = 300;					///< Number of frames in a trace capture (started w/ the "captureTrace" key)
+	int		traceStartFrame = -1;				///< Frame to automatically start a trace capture at (-1 for none)
+
+	bool	headless = false;					///< Run sessions w/o rendering (hidden window, fixed timestep, scripted input)
+	float	headlessTimeStep = 1.0f / 240.0f;	///< Fixed simulation timestep (in seconds) for headless mode
+	String	headlessInputScript = "";			///< Input script (Any file) to play back in headless mode
+	int		headlessRandomSeed = 0;				///< Random seed for headless mode (so runs are repeatable)
+	float	headlessDuration = 0.0f;			///< Simulated time (in seconds) to run for in headless mode (0 to run until all sessions are complete)
+	AimAgentConfig aimAgent;					///< Synthetic player for headless mode
 
     StartupConfig() {};
 
@@ -29,6 +81,20 @@ public:
             reader.getIfPresent("experimentConfigPath", experimentConfigPath);
             reader.getIfPresent("userConfigPath", userConfigPath);
             reader.getIfPresent("audioEnable", audioEnable);
+			reader.getIfPresent("collisionCachePath", collisionCachePath);
+			reader.getIfPresent("traceFrames", traceFrames);
+			reader.getIfPresent("traceStartFrame", traceStartFrame);
+			reader.getIfPresent("headless", headless);
+			reader.getIfPresent("headlessTimeStep", headlessTimeStep);
+			reader.getIfPresent("headlessInputScript", headlessInputScript);
+			reader.getIfPresent("headlessRandomSeed", headlessRandomSeed);
+			reader.getIfPresent("headlessDuration", headlessDuration);
+			{
+				Any agentAny;
+				if (reader.getIfPresent("aimAgent", agentAny)) {
+					aimAgent.load(AnyTableReader(agentAny));
+				}
+			}
             break;
         default:
             debugPrintf("Settings version '%d' not recognized in StartupConfig.\n", settingsVersion);
@@ -45,6 +111,17 @@ public:
         a["experimentConfigPath"] = experimentConfigPath;
         a["userConfigPath"] = userConfigPath;
         a["audioEnable"] = audioEnable;
+		a["collisionCachePath"] = collisionCachePath;
+		a["traceFrames"] = traceFrames;
+		a["traceStartFrame"] = traceStartFrame;
+		if (forceAll || headless) {
+			a["headless"] = headless;
+			a["headlessTimeStep"] = headlessTimeStep;
+			a["headlessInputScript"] = headlessInputScript;
+			a["headlessRandomSeed"] = headlessRandomSeed;
+			a["headlessDuration"] = headlessDuration;
+			a["aimAgent"] = aimAgent.addToAny(Any(Any::TABLE));
+		}
         return a;
     }
 
@@ -89,6 +166,7 @@ public:
 		map.set("moveWaypointOut", Array<GKey>{ GKey::END });
 		map.set("moveWaypointRight", Array<GKey>{ GKey::INSERT });
 		map.set("moveWaypointLeft", Array<GKey>{ GKey::DELETE });
+		map.set("captureTrace", Array<GKey>{ GKey::F8 });
 		getUiKeyMapping();
 	};
 
@@ -534,15 +612,16 @@ public:
 		return nullptr;
 	}
 
-	/** Get the next session ID for a given user (by ID) */
-	String getNextSession(String userId) {
+	/** Get the next session ID for a given user (by ID), treating the (in progress) session assumeComplete as completed if specified */
+	String getNextSession(String userId, String assumeComplete = "") {
 		// Return the first valid session that has not been completed
 		shared_ptr<UserSessionStatus> status = getUserStatus(userId);
 		// Handle sequence mode here (can be repeats)
 		if (allowRepeat) {
 			int j = 0;
+			const int completed = status->completedSessions.size() + (assumeComplete.empty() ? 0 : 1);
 			for (int i = 0; i < status->sessionOrder.size(); i++) {
-				if (status->completedSessions.size() <= i) {						// If there aren't enough entries in completed sessions to support this
+				if (completed <= i) {						// If there aren't enough entries in completed sessions to support this
 					return status->sessionOrder[i];
 				}
 				// In the future consider cases where completedSessions doesn't exactly match sessionOrder here... (fine for now?)
@@ -551,7 +630,7 @@ public:
 		// Default mode here (no repeats)
 		else {
 			for (auto sess : status->sessionOrder) {
-				if (!status->completedSessions.contains(sess)) return sess;
+				if (!status->completedSessions.contains(sess) && sess != assumeComplete) return sess;
 			}
 		}
 		// If all sessions are complete return empty string
@@ -724,6 +803,8 @@ public:
 	Array<float>	accelGravity = { 9.8f, 9.8f };			///< Range of acceleration due to gravity in meters/s^2
 	Array<Destination> destinations;						///< Array of destinations to traverse
 	String			destSpace = "world";					///< Space to use for destinations (implies offset) can be "world" or "player"
+	String			destInterpolation = "linear";			///< Interpolation between destinations, can be "linear" or "spline"
+	shared_ptr<DestinationSpline> destSpline;				///< Spline precomputed from destinations (only when destInterpolation = "spline")
 	int				respawnCount = 0;						///< Number of times to respawn
 	AABox			bbox;									///< Bounding box
 	Array<bool>		axisLock = { false, false, false };					///< Array of axis lock values
@@ -770,6 +851,16 @@ public:
 			reader.getIfPresent("modelSpec", modelSpec);
 			reader.getIfPresent("destSpace", destSpace);
 			reader.getIfPresent("destinations", destinations);
+			reader.getIfPresent("destInterpolation", destInterpolation);
+			if (destInterpolation == "spline") {
+				// Build the spline coefficients/arc-length tables once here (shared by all targets spawned from this config)
+				if (destinations.size() > 1) {
+					destSpline = DestinationSpline::create(destinations);
+				}
+			}
+			else if (destInterpolation != "linear") {
+				throw format("Unrecognized \"destInterpolation\" value \"%s\" for target \"%s\". Valid options are \"linear\" or \"spline\"", destInterpolation, id);
+			}
 			reader.getIfPresent("respawnCount", respawnCount);
 			if (destSpace == "world" && destinations.size() == 0) {
 				reader.get("bounds", bbox, format("A world-space target must either specify destinations or a bounding box. See target: \"%s\"", id));
@@ -805,6 +896,7 @@ public:
 		if (destinations.size() > 0) {						// Destination-based target
 			a["destSpace"] = destSpace;
 			a["destinations"] = destinations;
+			a["destInterpolation"] = destInterpolation;
 		}
 		else {												// Parametric target
 			a["upperHemisphereOnly"] = upperHemisphereOnly;
@@ -924,6 +1016,12 @@ public:
 	int             frameDelay = 0;								///< Integer frame delay (in frames)
 	String          shader = "";								///< Option for a custom shader name
 	float           hFoV = 103.0f;							    ///< Field of view (horizontal) for the user
+	String			pacingMode = "sleep";						///< Frame pacing mode ("sleep" or "hybrid", see FramePacer)
+	float			pacingSpinMarginMs = 2.0f;					///< Time before the frame deadline to stop sleeping and spin (in hybrid pacing mode)
+	bool			lateLatchView = false;						///< Resample mouse input and update the view just before rendering
+	bool			jitFrameStart = false;						///< Delay the start of each frame so it finishes just before its deadline (see FrameScheduler)
+	float			jitPercentile = 0.95f;						///< Percentile of the recent phase costs used to predict the frame cost
+	float			jitMarginMs = 0.5f;							///< Time allowed (on top of the predicted frame cost) before the frame deadline
 
 	void load(AnyTableReader reader, int settingsVersion=1) {
 		switch (settingsVersion) {
@@ -932,6 +1030,18 @@ public:
 			reader.getIfPresent("frameDelay", frameDelay);
 			reader.getIfPresent("shader", shader);
 			reader.getIfPresent("horizontalFieldOfView", hFoV);
+			reader.getIfPresent("pacingMode", pacingMode);
+			reader.getIfPresent("pacingSpinMarginMs", pacingSpinMarginMs);
+			reader.getIfPresent("lateLatchView", lateLatchView);
+			reader.getIfPresent("jitFrameStart", jitFrameStart);
+			reader.getIfPresent("jitPercentile", jitPercentile);
+			reader.getIfPresent("jitMarginMs", jitMarginMs);
+			if (pacingMode != "sleep" && pacingMode != "hybrid") {
+				throw format("Unrecognized \"pacingMode\" value \"%s\". Valid options are \"sleep\" or \"hybrid\"", pacingMode.c_str());
+			}
+			if (jitPercentile <= 0.0f || jitPercentile > 1.0f) {
+				throw format("\"jitPercentile\" must be in (0, 1], got %f", jitPercentile);
+			}
 			break;
 		default:
 			throw format("Did not recognize settings version: %d", settingsVersion);
@@ -944,6 +1054,12 @@ public:
 		a["frameDelay"] = frameDelay;
 		a["horizontalFieldOfView"] = hFoV;
 		a["shader"] = shader;
+		a["pacingMode"] = pacingMode;
+		a["pacingSpinMarginMs"] = pacingSpinMarginMs;
+		a["lateLatchView"] = lateLatchView;
+		a["jitFrameStart"] = jitFrameStart;
+		a["jitPercentile"] = jitPercentile;
+		a["jitMarginMs"] = jitMarginMs;
 		return a;
 	}
 
@@ -1253,6 +1369,14 @@ public:
 	float           feedbackDuration = 1.0f;					///< Time in feedback state in seconds
 	// Trial count
 	int             defaultTrialCount = 5;						///< Default trial count
+	// Trajectory baking
+	bool			bakeTrajectories = false;					///< Pre-compute target trajectories (for taskDuration) at the start of each trial
+	float			bakeRate = 1000.0f;							///< Sample rate for baked trajectories (in Hz)
+	static const int maxBakeSamples = 1000000;					///< Limit on baked samples per target (taskDuration * bakeRate), ~12MB per target
+	// Simulation
+	float			simulationRate = 0.0f;						///< Fixed simulation rate (in Hz), 0 (default) to simulate one (variable) step per frame
+	bool			simulationThread = false;					///< Simulate target motion (and log trajectories) on a dedicated thread
+	float			simulationThreadRate = 1000.0f;				///< Rate for the simulation thread (in Hz)
 
 	void load(AnyTableReader reader, int settingsVersion = 1) {
 		switch (settingsVersion) {
@@ -1261,6 +1385,25 @@ public:
 			reader.getIfPresent("readyDuration", readyDuration);
 			reader.getIfPresent("taskDuration", taskDuration);
 			reader.getIfPresent("defaultTrialCount", defaultTrialCount);
+			reader.getIfPresent("bakeTrajectories", bakeTrajectories);
+			reader.getIfPresent("bakeRate", bakeRate);
+			reader.getIfPresent("simulationRate", simulationRate);
+			if (simulationRate < 0.0f) {
+				throw format("\"simulationRate\" must be non-negative (provided %f Hz)!", simulationRate);
+			}
+			reader.getIfPresent("simulationThread", simulationThread);
+			reader.getIfPresent("simulationThreadRate", simulationThreadRate);
+			if (simulationThread && simulationThreadRate <= 0.0f) {
+				throw format("\"simulationThreadRate\" must be positive when \"simulationThread\" is set (provided %f Hz)!", simulationThreadRate);
+			}
+			if (bakeTrajectories) {
+				if (bakeRate <= 0.0f) {
+					throw format("\"bakeRate\" must be positive when \"bakeTrajectories\" is set (provided %f Hz)!", bakeRate);
+				}
+				if (taskDuration * bakeRate > maxBakeSamples) {
+					throw format("\"bakeTrajectories\" requires \"taskDuration\" * \"bakeRate\" to be at most %d samples (%f s at %f Hz provided)!", maxBakeSamples, taskDuration, bakeRate);
+				}
+			}
 			break;
 		default:
 			throw format("Did not recognize settings version: %d", settingsVersion);
@@ -1273,6 +1416,11 @@ public:
 		a["readyDuration"] = readyDuration;
 		a["taskDuration"] = taskDuration;
 		a["defaultTrialCount"] = defaultTrialCount;
+		a["bakeTrajectories"] = bakeTrajectories;
+		a["bakeRate"] = bakeRate;
+		a["simulationRate"] = simulationRate;
+		a["simulationThread"] = simulationThread;
+		a["simulationThreadRate"] = simulationThreadRate;
 		return a;
 	}
 };
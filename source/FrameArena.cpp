@@ -0,0 +1,97 @@
+#include "FrameArena.h"
+#include <cstdlib>
+#include <new>
+
+// Count heap allocations per thread. Release builds count the global operator new below (C++ allocations). Debug builds count
+// every CRT heap allocation (including G3D's System::malloc, which G3D Arrays allocate through) w/ the debug heap's allocation hook instead.
+static thread_local uint64 t_allocationCount = 0;
+
+#ifdef _DEBUG
+#include <crtdbg.h>
+
+static int __cdecl countAllocation(int allocType, void* data, size_t bytes, int blockType, long request, const unsigned char* file, int line) {
+	// Skip the CRT's own (internal) blocks
+	if ((allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC) && blockType != _CRT_BLOCK) {
+		t_allocationCount++;
+	}
+	return TRUE;
+}
+
+static const bool s_crtHooked = (_CrtSetAllocHook(&countAllocation), true);
+#else
+static const bool s_crtHooked = false;
+#endif
+
+void* operator new(size_t bytes) {
+	// Counted by the CRT allocation hook (in debug builds)
+	if (!s_crtHooked) t_allocationCount++;
+	void* p = std::malloc(bytes > 0 ? bytes : 1);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t bytes) {
+	return operator new(bytes);
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, size_t bytes) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, size_t bytes) noexcept {
+	std::free(p);
+}
+
+uint64 FrameArena::threadAllocationCount() {
+	return t_allocationCount;
+}
+
+FrameArena::FrameArena(size_t capacity) : m_capacity(capacity) {
+	m_block = static_cast<uint8*>(System::alignedMalloc(m_capacity, Alignment));
+}
+
+FrameArena::~FrameArena() {
+	for (uint8* block : m_overflow) {
+		System::alignedFree(block);
+	}
+	System::alignedFree(m_block);
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+	alignment = max(alignment, Alignment);
+	const size_t start = (m_offset + alignment - 1) & ~(alignment - 1);
+	if (start + bytes <= m_capacity) {
+		m_offset = start + bytes;
+		return m_block + start;
+	}
+
+	// Doesn't fit, give the allocation a block of its own (until the next reset)
+	uint8* block = static_cast<uint8*>(System::alignedMalloc(max(bytes, (size_t)1), alignment));
+	m_overflow.push_back(block);
+	m_overflowBytes += bytes + alignment;
+	return block;
+}
+
+void FrameArena::reset() {
+	m_peakBytes = max(m_peakBytes, m_offset + m_overflowBytes);
+	if (m_overflow.size() > 0) {
+		// Replace the main block w/ one large enough for everything allocated this time around
+		for (uint8* block : m_overflow) {
+			System::alignedFree(block);
+		}
+		m_overflow.clear();
+		System::alignedFree(m_block);
+		m_capacity = max(m_capacity * 2, m_offset + m_overflowBytes);
+		m_block = static_cast<uint8*>(System::alignedMalloc(m_capacity, Alignment));
+		m_overflowBytes = 0;
+	}
+	m_offset = 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <string>
+#include <vector>
+
+/** Linear (bump) allocator for transient data that is freed all at once by reset(), i.e. once per frame (or logger drain).
+	FrameArena is a G3D MemoryManager so G3D Arrays can allocate from it (see Array::clearAndSetMemoryManager()), use
+	ArenaAllocator for std containers. Individual frees are no-ops, so containers using the arena must not outlive the next reset().
+	Allocations that don't fit in the arena go to overflow blocks, which are coalesced into one (larger) block on reset. Once the arena
+	has grown to the peak per-frame size it does no further heap allocation. Not thread safe. */
+class FrameArena : public MemoryManager {
+protected:
+	static const size_t		Alignment = 16;						///< Default allocation alignment (matches System::malloc)
+
+	uint8*					m_block = nullptr;					///< Main block
+	size_t					m_capacity = 0;						///< Size of the main block (in bytes)
+	size_t					m_offset = 0;						///< Bytes used in the main block
+	std::vector<uint8*>		m_overflow;							///< Overflow blocks allocated since the last reset
+	size_t					m_overflowBytes = 0;				///< Total size of the overflow blocks (in bytes)
+	size_t					m_peakBytes = 0;					///< Largest number of bytes allocated between resets
+
+	FrameArena(size_t capacity);
+
+public:
+	static shared_ptr<FrameArena> create(size_t capacity = 64 * 1024) {
+		return createShared<FrameArena>(capacity);
+	}
+
+	virtual ~FrameArena();
+
+	/** Allocate bytes w/ the given (power of 2) alignment, the memory is valid until the next reset() */
+	void* allocate(size_t bytes, size_t alignment = Alignment);
+
+	/** Free everything allocated from the arena (growing it to fit the peak usage if it overflowed) */
+	void reset();
+
+	size_t capacity() const { return m_capacity; }
+	size_t peakBytes() const { return m_peakBytes; }
+
+	// MemoryManager interface
+	virtual void* alloc(size_t s) override { return allocate(s); }
+	virtual void free(void* ptr) override {}
+	virtual bool isThreadsafe() const override { return false; }
+
+	/** Number of heap allocations made by the calling thread since it started, the difference across a frame is that frame's allocation count.
+		Release builds count operator new only, debug builds count all CRT heap allocations (including G3D's System::malloc). */
+	static uint64 threadAllocationCount();
+};
+
+/** Allocator for std containers that allocates from a FrameArena */
+template<typename T> class ArenaAllocator {
+public:
+	using value_type = T;
+
+	FrameArena* arena;
+
+	ArenaAllocator(FrameArena* a) : arena(a) {}
+	template<typename U> ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+	void deallocate(T* p, size_t n) {}
+
+	template<typename U> bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+	template<typename U> bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template<typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
@@ -0,0 +1,58 @@
+#include "FramePacer.h"
+#include <immintrin.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+
+const double WakeErrorHistogram::BinEdgesUs[NumBins - 1] = { -1000.0, -500.0, -250.0, -100.0, -50.0, -20.0, 0.0, 20.0, 50.0, 100.0, 250.0, 500.0, 1000.0 };
+
+void WakeErrorHistogram::add(RealTime error) {
+	const double errorUs = 1e6 * error;
+	int bin = 0;
+	while (bin < NumBins - 1 && errorUs >= BinEdgesUs[bin]) bin++;
+	counts[bin]++;
+	count++;
+	sumUs += errorUs;
+	maxAbsUs = max(maxAbsUs, abs(errorUs));
+}
+
+FramePacer::~FramePacer() {
+	if (m_timerPeriodSet) {
+		timeEndPeriod(1);
+	}
+}
+
+FramePacer::Mode FramePacer::modeFromString(const String& mode) {
+	if (mode == "sleep") return Mode::Sleep;
+	if (mode == "hybrid") return Mode::Hybrid;
+	throw format("Unrecognized frame pacing mode \"%s\" (must be \"sleep\" or \"hybrid\")!", mode.c_str());
+}
+
+String FramePacer::modeToString(Mode mode) {
+	return (mode == Mode::Hybrid) ? "hybrid" : "sleep";
+}
+
+void FramePacer::setMode(Mode mode, RealTime spinMargin) {
+	m_mode = mode;
+	m_spinMargin = max(0.0, spinMargin);
+
+	// The default (~15.6ms) timer resolution makes the OS sleep too coarse to get within the spin margin
+	const bool wantTimerPeriod = (mode == Mode::Hybrid);
+	if (wantTimerPeriod != m_timerPeriodSet) {
+		if (wantTimerPeriod) timeBeginPeriod(1);
+		else timeEndPeriod(1);
+		m_timerPeriodSet = wantTimerPeriod;
+	}
+}
+
+void FramePacer::waitUntil(RealTime deadline) {
+	const RealTime sleepTime = deadline - System::time() - m_spinMargin;
+	if (sleepTime > 0.0) {
+		System::sleep(sleepTime);
+	}
+	RealTime now = System::time();
+	while (now < deadline) {
+		_mm_pause();
+		now = System::time();
+	}
+	m_wakeErrors.add(now - deadline);
+}
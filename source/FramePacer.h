@@ -0,0 +1,58 @@
+#pragma once
+#include <G3D/G3D.h>
+
+/** Histogram of frame wake-up error (actual - requested wake time) */
+class WakeErrorHistogram {
+public:
+	static const int NumBins = 14;
+	static const double BinEdgesUs[NumBins - 1];		///< Bin i covers [BinEdgesUs[i-1], BinEdgesUs[i]) (the outer bins are unbounded)
+
+	int			counts[NumBins] = {};
+	int			count = 0;
+	double		sumUs = 0.0;
+	double		maxAbsUs = 0.0;
+
+	void add(RealTime error);
+	void clear() { *this = WakeErrorHistogram(); }
+
+	/** Lower bound of a bin (in microseconds, -inf for the first bin) */
+	static double binLowerUs(int bin) { return (bin == 0) ? -finf() : BinEdgesUs[bin - 1]; }
+	/** Upper bound of a bin (in microseconds, inf for the last bin) */
+	static double binUpperUs(int bin) { return (bin == NumBins - 1) ? finf() : BinEdgesUs[bin]; }
+};
+
+/** Waits out the remainder of each frame and records how far from the requested time each wait woke up.
+	In hybrid mode the OS sleep only covers the wait up to spinMargin before the deadline, the rest is a busy-wait on
+	System::time() (which is backed by the high resolution performance counter), trading some CPU for frame-time stability. */
+class FramePacer {
+public:
+	enum class Mode {
+		Sleep,			///< OS sleep only (App::onWait() w/ overshoot compensation)
+		Hybrid			///< OS sleep to spinMargin before the deadline, then spin
+	};
+
+protected:
+	Mode					m_mode = Mode::Sleep;
+	RealTime				m_spinMargin = 0.002;
+	bool					m_timerPeriodSet = false;		///< Has the system timer resolution been raised (for hybrid mode)?
+	WakeErrorHistogram		m_wakeErrors;
+
+public:
+	~FramePacer();
+
+	/** Parse a mode name ("sleep" or "hybrid"), throws for anything else */
+	static Mode modeFromString(const String& mode);
+	static String modeToString(Mode mode);
+
+	void setMode(Mode mode, RealTime spinMargin);
+	Mode mode() const { return m_mode; }
+
+	/** Wait until deadline (a System::time()), hybrid mode only */
+	void waitUntil(RealTime deadline);
+
+	/** Record the wake-up error of a wait done elsewhere (sleep mode) */
+	void recordWakeError(RealTime error) { m_wakeErrors.add(error); }
+
+	const WakeErrorHistogram& wakeErrors() const { return m_wakeErrors; }
+	void clearWakeErrors() { m_wakeErrors.clear(); }
+};
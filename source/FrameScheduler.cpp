@@ -0,0 +1,16 @@
+#include "FrameScheduler.h"
+
+void FrameScheduler::addFrame(const RealTime cost[NumPhases]) {
+	for (int i = 0; i < NumPhases; i++) {
+		m_phaseCosts[i].add(cost[i]);
+	}
+}
+
+RealTime FrameScheduler::predict(Phase firstPhase) const {
+	RealTime cost = 0.0;
+	for (int i = firstPhase; i < NumPhases; i++) {
+		if (m_phaseCosts[i].size() == 0) continue;
+		cost += m_phaseCosts[i].histogram().percentile(m_percentile);
+	}
+	return cost;
+}
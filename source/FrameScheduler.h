@@ -0,0 +1,38 @@
+#pragma once
+#include <G3D/G3D.h>
+#include "FrameStats.h"
+
+/** Predicts how long the rest of a frame will take from the measured cost of each oneFrame() phase over recent frames.
+	The prediction is the sum of a (high) percentile of each phase's cost, so the frame can be started as late as possible
+	(sampling input later) while still finishing before its deadline on all but the slowest frames. */
+class FrameScheduler {
+public:
+	enum Phase {
+		Input,
+		Simulation,
+		Pose,
+		Render,				///< From the end of the wait/pose to the buffer swap (includes the late latch and GPU submission)
+		NumPhases
+	};
+
+	static const int Window = 120;			///< Frames of history used for each phase's cost
+
+protected:
+	RollingFrameStats		m_phaseCosts[NumPhases] = { Window, Window, Window, Window };
+	float					m_percentile = 0.95f;		///< Percentile of each phase's cost used for the prediction
+	RealTime				m_margin = 0.0005;			///< Extra time allowed for each frame (on top of the prediction)
+
+public:
+	void configure(float percentile, RealTime margin) {
+		m_percentile = percentile;
+		m_margin = margin;
+	}
+
+	/** Add the measured cost of each phase of a frame (in seconds) */
+	void addFrame(const RealTime cost[NumPhases]);
+
+	/** Predicted time from the start of firstPhase to the end of the frame (not including the margin), 0 before any frames are added */
+	RealTime predict(Phase firstPhase) const;
+
+	RealTime margin() const { return m_margin; }
+};
@@ -0,0 +1,73 @@
+#include "FrameStats.h"
+
+const double FrameTimeHistogram::MinTime = 50e-6;
+const double FrameTimeHistogram::Growth = 1.02;		// 1.02^500 * 50us ~= 1s
+
+int FrameTimeHistogram::bucket(RealTime t) {
+	if (!(t > MinTime)) return 0;
+	static const double invLogGrowth = 1.0 / log(Growth);
+	return min(NumBuckets - 1, int(log(t / MinTime) * invLogGrowth));
+}
+
+void FrameTimeHistogram::percentiles(const float* p, RealTime* result, int n) const {
+	int cumulative = 0;
+	int b = 0;
+	for (int i = 0; i < n; i++) {
+		// Smallest bucket w/ at least p of the samples at or below it
+		const int target = max(1, iCeil(p[i] * m_count));
+		while (b < NumBuckets - 1 && cumulative + m_counts[b] < target) {
+			cumulative += m_counts[b];
+			b++;
+		}
+		result[i] = (m_count > 0) ? MinTime * pow(Growth, b + 0.5) : 0.0;
+	}
+}
+
+RealTime FrameTimeHistogram::percentile(float p) const {
+	RealTime result;
+	percentiles(&p, &result, 1);
+	return result;
+}
+
+RollingFrameStats::RollingFrameStats(int window) : m_window(max(1, window)) {
+	m_samples.resize(m_window);
+	m_minQueue.index.resize(m_window);
+	m_maxQueue.index.resize(m_window);
+}
+
+void RollingFrameStats::push(MonotonicQueue& queue, uint64 i, bool isMin) {
+	const float value = sample(i);
+	while (queue.length > 0) {
+		const float back = sample(queue.index[(queue.head + queue.length - 1) % m_window]);
+		if (isMin ? (back < value) : (back > value)) break;
+		queue.length--;
+	}
+	queue.index[(queue.head + queue.length) % m_window] = i;
+	queue.length++;
+}
+
+void RollingFrameStats::add(RealTime dt) {
+	const uint64 i = m_added++;
+
+	// Evict the sample leaving the window (it can only be at the front of the queues)
+	if (i >= uint64(m_window)) {
+		const uint64 oldest = i - m_window;
+		const float old = sample(oldest);
+		m_histogram.remove(old);
+		m_sum -= old;
+		for (MonotonicQueue* queue : { &m_minQueue, &m_maxQueue }) {
+			if (queue->length > 0 && queue->index[queue->head] == oldest) {
+				queue->head = (queue->head + 1) % m_window;
+				queue->length--;
+			}
+		}
+	}
+
+	// Store/sum the float sample so eviction removes exactly what was added
+	const float value = float(dt);
+	m_samples[int(i % uint64(m_window))] = value;
+	m_histogram.add(value);
+	m_sum += value;
+	push(m_minQueue, i, true);
+	push(m_maxQueue, i, false);
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <G3D/G3D.h>
+
+/** Fixed bucket histogram of frame durations w/ log spaced buckets (each ~2% wide, from 50us to 1s).
+	Percentiles are accurate to a bucket width and cost a scan of the (fixed) buckets, independent of the sample count. */
+class FrameTimeHistogram {
+public:
+	static const int NumBuckets = 501;
+
+protected:
+	static const double MinTime;						///< Lower edge of the first bucket (shorter durations go in the first bucket)
+	static const double Growth;							///< Ratio of successive bucket edges
+
+	int			m_counts[NumBuckets] = {};
+	int			m_count = 0;
+
+	static int bucket(RealTime t);
+
+public:
+	void add(RealTime t) { m_counts[bucket(t)]++; m_count++; }
+	void remove(RealTime t) { m_counts[bucket(t)]--; m_count--; }
+	void clear() { *this = FrameTimeHistogram(); }
+	int count() const { return m_count; }
+
+	/** Compute several percentiles (in [0, 1], ascending order) in one pass over the buckets, returns the bucket centers */
+	void percentiles(const float* p, RealTime* result, int n) const;
+	RealTime percentile(float p) const;
+};
+
+/** Frame duration statistics over the last window frames. Min/max are kept in monotonic queues and percentiles in a
+	FrameTimeHistogram, so adding a sample is O(1) (amortized) rather than a scan of the window. */
+class RollingFrameStats {
+protected:
+	const int				m_window;
+	Array<float>			m_samples;					///< Circular buffer, sample i (in order added) is at i % m_window
+	uint64					m_added = 0;				///< Samples added so far
+	double					m_sum = 0.0;				///< Sum of the samples in the window
+	FrameTimeHistogram		m_histogram;
+
+	/** Monotonic queue of sample indices (circular, each queue holds at most m_window indices) */
+	struct MonotonicQueue {
+		Array<uint64>	index;
+		int				head = 0;
+		int				length = 0;
+	};
+	MonotonicQueue			m_minQueue;					///< Sample values increase from the front
+	MonotonicQueue			m_maxQueue;					///< Sample values decrease from the front
+
+	float sample(uint64 i) const { return m_samples[int(i % uint64(m_window))]; }
+
+	/** Drop the queue's back entries that won't be the extreme while sample i is in the window then append i */
+	void push(MonotonicQueue& queue, uint64 i, bool isMin);
+
+public:
+	RollingFrameStats(int window);
+
+	/** Add a measured frame duration (in seconds) */
+	void add(RealTime dt);
+
+	int size() const { return int(min(m_added, uint64(m_window))); }
+	float minimum() const { return m_minQueue.length > 0 ? sample(m_minQueue.index[m_minQueue.head]) : 0.0f; }
+	float maximum() const { return m_maxQueue.length > 0 ? sample(m_maxQueue.index[m_maxQueue.head]) : 0.0f; }
+	float mean() const { return size() > 0 ? float(m_sum / size()) : 0.0f; }
+	const FrameTimeHistogram& histogram() const { return m_histogram; }
+};
+
+/** Frame duration statistics accumulated over a whole session (logged to the results file) */
+struct SessionFrameStats {
+	FrameTimeHistogram		histogram;
+	double					sum = 0.0;
+	float					minimum = finf();
+	float					maximum = 0.0f;
+
+	void add(RealTime dt) {
+		histogram.add(dt);
+		sum += dt;
+		minimum = min(minimum, float(dt));
+		maximum = max(maximum, float(dt));
+	}
+	void clear() { *this = SessionFrameStats(); }
+	int count() const { return histogram.count(); }
+	float mean() const { return count() > 0 ? float(sum / count()) : 0.0f; }
+};
@@ -0,0 +1,82 @@
+#include "HeadlessDriver.h"
+#include "PlayerEntity.h"
+#include "SimClock.h"
+
+HeadlessInputEvent::HeadlessInputEvent(const Any& any) {
+	AnyTableReader reader(any);
+	reader.get("time", time, "Headless input events must specify a \"time\"!");
+	reader.getIfPresent("press", press);
+	reader.getIfPresent("release", release);
+	hasView = reader.getIfPresent("view", view);
+	reader.verifyDone();
+}
+
+shared_ptr<HeadlessDriver> HeadlessDriver::create(SimTime timeStep, SimTime duration, const String& scriptFile) {
+	const shared_ptr<HeadlessDriver>& driver = createShared<HeadlessDriver>(timeStep, duration);
+	if (!scriptFile.empty()) {
+		driver->loadScript(scriptFile);
+	}
+	return driver;
+}
+
+void HeadlessDriver::loadScript(const String& scriptFile) {
+	if (!FileSystem::exists(scriptFile)) {
+		throw format("Headless input script \"%s\" not found!", scriptFile.c_str());
+	}
+	Any any = Any::fromFile(scriptFile);
+	AnyTableReader reader(any);
+	Array<Any> events;
+	reader.get("events", events, "Headless input scripts must specify an \"events\" array!");
+
+	m_events.fastClear();
+	for (const Any& e : events) {
+		m_events.append(HeadlessInputEvent(e));
+	}
+	// Stable sort so events w/ the same time apply in file order
+	std::stable_sort(m_events.begin(), m_events.end(), [](const HeadlessInputEvent& a, const HeadlessInputEvent& b) {
+		return a.time < b.time;
+	});
+	m_nextEvent = 0;
+}
+
+void HeadlessDriver::injectKey(UserInput* ui, GKey key, bool pressed) {
+	GEvent e;
+	if (key == GKey::LEFT_MOUSE || key == GKey::MIDDLE_MOUSE || key == GKey::RIGHT_MOUSE) {
+		e.type = pressed ? GEventType::MOUSE_BUTTON_DOWN : GEventType::MOUSE_BUTTON_UP;
+		e.button.button = (key == GKey::LEFT_MOUSE) ? 0 : ((key == GKey::MIDDLE_MOUSE) ? 1 : 2);
+		e.button.state = pressed ? GButtonState::PRESSED : GButtonState::RELEASED;
+	}
+	else {
+		e.type = pressed ? GEventType::KEY_DOWN : GEventType::KEY_UP;
+		e.key.keysym.sym = key;
+		e.key.state = pressed ? GButtonState::PRESSED : GButtonState::RELEASED;
+	}
+	ui->processEvent(e);
+}
+
+void HeadlessDriver::applyInput(UserInput* ui, const shared_ptr<PlayerEntity>& player, const Table<String, Array<GKey>>& keyMap) {
+	// Apply every event that is due (time is compared against the start of this step)
+	while (m_nextEvent < m_events.size() && m_events[m_nextEvent].time <= m_time) {
+		const HeadlessInputEvent& e = m_events[m_nextEvent++];
+		if (!e.press.empty() || !e.release.empty()) {
+			const String& action = e.press.empty() ? e.release : e.press;
+			const Array<GKey>* keys = keyMap.getPointer(action);
+			if (isNull(keys) || keys->size() == 0) {
+				throw format("Headless input script uses unmapped action \"%s\"!", action.c_str());
+			}
+			injectKey(ui, (*keys)[0], !e.press.empty());
+		}
+		if (e.hasView && notNull(player)) {
+			player->setView(e.view.x * units::degrees(), e.view.y * units::degrees());
+		}
+	}
+}
+
+void HeadlessDriver::advance() {
+	m_time += m_timeStep;
+	SimClock::advance(m_timeStep);
+}
+
+bool HeadlessDriver::finished() const {
+	return (m_duration > 0.0) && (m_time >= m_duration);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <G3D/G3D.h>
+
+class PlayerEntity;
+
+/** A single scripted input event */
+struct HeadlessInputEvent {
+	SimTime		time = 0.0;					///< Simulated time (in seconds since start) at which the event is applied
+	String		press = "";					///< Key mapped action to press (i.e. "shoot", "jump"), empty for none
+	String		release = "";				///< Key mapped action to release, empty for none
+	bool		hasView = false;			///< Does this event set the view direction?
+	Vector2		view = Vector2::zero();		///< View direction (heading, tilt) in degrees
+
+	HeadlessInputEvent() {}
+	HeadlessInputEvent(const Any& any);
+};
+
+/** Drives the app w/o rendering: plays back an input script against a simulated clock advanced at a fixed timestep.
+	Input is injected as (synthetic) events into UserInput, so the same input handling code runs as in normal play. */
+class HeadlessDriver : public ReferenceCountedObject {
+protected:
+	Array<HeadlessInputEvent>	m_events;			///< Scripted input events (sorted by time)
+	int							m_nextEvent = 0;	///< Index of the next event to apply
+	SimTime						m_time = 0.0;		///< Simulated time since start
+	SimTime						m_timeStep;			///< Fixed simulation timestep
+	SimTime						m_duration;			///< Simulated time to run for (0 for no limit)
+
+	HeadlessDriver(SimTime timeStep, SimTime duration) : m_timeStep(timeStep), m_duration(duration) {}
+
+public:
+	/** Inject a synthetic key/mouse button event for the given key, must be called between UserInput::beginEvents() and endEvents() */
+	static void injectKey(UserInput* ui, GKey key, bool pressed);
+
+	/** Create a driver, loading the input script (if scriptFile isn't empty) */
+	static shared_ptr<HeadlessDriver> create(SimTime timeStep, SimTime duration, const String& scriptFile = "");
+
+	/** Load an input script from an Any file w/ an "events" array */
+	void loadScript(const String& scriptFile);
+
+	SimTime timeStep() const { return m_timeStep; }
+	SimTime time() const { return m_time; }
+
+	/** Apply all events due at the current time, must be called between UserInput::beginEvents() and endEvents() */
+	void applyInput(UserInput* ui, const shared_ptr<PlayerEntity>& player, const Table<String, Array<GKey>>& keyMap);
+
+	/** Advance the driver (and simulated clock) by one timestep */
+	void advance();
+
+	/** Has the configured duration elapsed? (always false when no duration is set) */
+	bool finished() const;
+};
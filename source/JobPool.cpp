@@ -0,0 +1,169 @@
+#include "JobPool.h"
+#include "TraceRecorder.h"
+
+JobPool::JobPool(int workerCount) : m_queuedJobs(0) {
+	if (workerCount < 0) {
+		workerCount = max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+
+	// One queue for the calling thread plus one per worker
+	for (int i = 0; i <= workerCount; i++) {
+		m_queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+	}
+
+	m_running = true;
+	for (int i = 0; i < workerCount; i++) {
+		m_threads.push_back(std::thread(&JobPool::workerThreadEntry, this, i + 1));
+	}
+}
+
+JobPool::~JobPool() {
+	{
+		std::lock_guard<std::mutex> lk(m_wakeMutex);
+		m_running = false;
+	}
+	m_wakeCV.notify_all();
+	for (std::thread& t : m_threads) {
+		t.join();
+	}
+}
+
+bool JobPool::popJob(int idx, Job& job) {
+	WorkQueue& queue = *m_queues[idx];
+	std::lock_guard<std::mutex> lk(queue.mutex);
+	if (queue.jobs.empty()) return false;
+	job = std::move(queue.jobs.back());
+	queue.jobs.pop_back();
+	--m_queuedJobs;
+	return true;
+}
+
+bool JobPool::stealJob(int idx, Job& job) {
+	const int queueCount = (int)m_queues.size();
+	for (int i = 1; i < queueCount; i++) {
+		WorkQueue& queue = *m_queues[(idx + i) % queueCount];
+		std::lock_guard<std::mutex> lk(queue.mutex);
+		if (queue.jobs.empty()) continue;
+		job = std::move(queue.jobs.front());
+		queue.jobs.pop_front();
+		--m_queuedJobs;
+		return true;
+	}
+	return false;
+}
+
+void JobPool::pushJob(int idx, Job&& job) {
+	WorkQueue& queue = *m_queues[idx];
+	std::lock_guard<std::mutex> lk(queue.mutex);
+	queue.jobs.push_back(std::move(job));
+	++m_queuedJobs;
+}
+
+bool JobPool::popBackgroundJob(Job& job) {
+	std::lock_guard<std::mutex> lk(m_background.mutex);
+	if (m_background.jobs.empty()) return false;
+	job = std::move(m_background.jobs.front());
+	m_background.jobs.pop_front();
+	--m_queuedJobs;
+	return true;
+}
+
+void JobPool::wakeWorkers() {
+	// Take the lock so a worker can't miss the wakeup between its check and wait
+	{
+		std::lock_guard<std::mutex> lk(m_wakeMutex);
+	}
+	m_wakeCV.notify_all();
+}
+
+void JobPool::runInBackground(Job job) {
+	if (m_threads.empty()) {
+		job();
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lk(m_background.mutex);
+		m_background.jobs.push_back(std::move(job));
+		++m_queuedJobs;
+	}
+	wakeWorkers();
+}
+
+void JobPool::workerThreadEntry(int queueIdx) {
+	Job job;
+	TraceRecorder::setThreadName("JobPool worker");
+	while (true) {
+		if (popJob(queueIdx, job) || stealJob(queueIdx, job) || popBackgroundJob(job)) {
+			TraceRecorder::begin("Job");
+			job();
+			TraceRecorder::end();
+			job = nullptr;
+			continue;
+		}
+
+		// Nothing to do, sleep until more jobs are pushed
+		std::unique_lock<std::mutex> lk(m_wakeMutex);
+		m_wakeCV.wait(lk, [this] {
+			return !m_running || m_queuedJobs > 0;
+		});
+		if (!m_running) return;
+	}
+}
+
+void JobPool::parallelFor(int count, const std::function<void(int)>& fn, int grainSize) {
+	if (count <= 0) return;
+	grainSize = max(grainSize, 1);
+	const int jobCount = (count + grainSize - 1) / grainSize;
+
+	// Not worth distributing, just run inline
+	if (jobCount < 2 || m_threads.empty()) {
+		for (int i = 0; i < count; i++) {
+			fn(i);
+		}
+		return;
+	}
+
+	// Completion is counted under doneMutex, so the last job can't still be signalling when this returns
+	int remaining = jobCount;
+	std::mutex doneMutex;
+	std::condition_variable doneCV;
+	std::exception_ptr error;
+
+	// Deal the jobs round robin across the deques (starting w/ the calling thread's), each thread starts on its own share
+	const int queueCount = (int)m_queues.size();
+	for (int j = 0; j < jobCount; j++) {
+		const int begin = j * grainSize;
+		const int end = min(begin + grainSize, count);
+		pushJob(j % queueCount, [&fn, &remaining, &doneMutex, &doneCV, &error, begin, end]() {
+			std::exception_ptr jobError;
+			try {
+				for (int i = begin; i < end; i++) {
+					fn(i);
+				}
+			}
+			catch (...) {
+				jobError = std::current_exception();
+			}
+			std::lock_guard<std::mutex> lk(doneMutex);
+			if (jobError && !error) error = jobError;
+			if (--remaining == 0) doneCV.notify_one();
+		});
+	}
+
+	wakeWorkers();
+
+	// Participate until no jobs are left to take, then sleep until the ones still running complete
+	Job job;
+	while (popJob(0, job) || stealJob(0, job)) {
+		job();
+		job = nullptr;
+	}
+	{
+		std::unique_lock<std::mutex> lk(doneMutex);
+		doneCV.wait(lk, [&remaining] { return remaining == 0; });
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
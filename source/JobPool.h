@@ -0,0 +1,70 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/** Simple job system using one work-stealing deque per thread.
+	The calling (main) thread owns deque 0 and participates in executing jobs, workers pop
+	from the back of their own deque and steal from the front of the others when empty.
+	parallelFor() deals its jobs round robin across all the deques, background jobs (see runInBackground()) go to a
+	separate queue that only the workers take from, so the calling thread never picks up long running work. */
+class JobPool : public ReferenceCountedObject {
+public:
+	using Job = std::function<void()>;
+
+protected:
+	/** Deque of jobs (owner uses the back, thieves use the front) */
+	struct WorkQueue {
+		std::mutex			mutex;
+		std::deque<Job>		jobs;
+	};
+
+	std::vector<std::thread>				m_threads;			///< Worker threads (m_queues[i+1] belongs to m_threads[i])
+	std::vector<std::unique_ptr<WorkQueue>>	m_queues;			///< Work queues, index 0 is for the calling thread
+	WorkQueue								m_background;		///< Background jobs (workers only, run once the work queues are empty)
+
+	bool						m_running = false;				///< Workers exit once this is cleared
+	std::atomic<int>			m_queuedJobs;					///< Number of jobs sitting in any queue
+	std::mutex					m_wakeMutex;					///< Mutex for m_wakeCV
+	std::condition_variable		m_wakeCV;						///< Wakes idle workers when jobs are pushed
+
+	void workerThreadEntry(int queueIdx);
+
+	/** Pop a job from the back of queue idx */
+	bool popJob(int idx, Job& job);
+
+	/** Steal a job from the front of any queue other than idx */
+	bool stealJob(int idx, Job& job);
+
+	/** Push a job onto the back of queue idx (caller is responsible for waking the workers) */
+	void pushJob(int idx, Job&& job);
+
+	/** Pop a job from the front of the background queue */
+	bool popBackgroundJob(Job& job);
+
+	/** Wake the idle workers */
+	void wakeWorkers();
+
+public:
+	/** Create a pool w/ the given number of worker threads (in addition to the calling thread), default is one less than the core count */
+	JobPool(int workerCount = -1);
+	virtual ~JobPool();
+
+	static shared_ptr<JobPool> create(int workerCount = -1) {
+		return createShared<JobPool>(workerCount);
+	}
+
+	int workerCount() const { return (int)m_threads.size(); }
+
+	/** Call fn(i) for i in [0, count) using the pool, returning once all calls have completed.
+		Indices are split into jobs of up to grainSize, with fewer than 2 jobs everything runs inline.
+		The first exception thrown by fn (if any) is rethrown here on the calling thread. */
+	void parallelFor(int count, const std::function<void(int)>& fn, int grainSize = 1);
+
+	/** Run job on a worker thread w/o waiting for it (runs inline if there are no workers). Queued jobs are completed before the pool is destroyed. */
+	void runInBackground(Job job);
+};
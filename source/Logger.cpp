@@ -1,5 +1,7 @@
 #include "Logger.h"
 #include "Session.h"
+#include "SimClock.h"
+#include <cstdarg>
 
 // TODO: Replace with the G3D timestamp uses.
 // utility function for generating a unique timestamp.
@@ -8,22 +10,54 @@ String Logger::genUniqueTimestamp() {
 }
 
 FILETIME Logger::getFileTime() {
-	FILETIME ft;
-	GetSystemTimePreciseAsFileTime(&ft);
-	return ft;
+	return SimClock::fileTime();
+}
+
+FILETIME Logger::offsetFileTime(FILETIME ft, double seconds) {
+	ULARGE_INTEGER t;
+	t.LowPart = ft.dwLowDateTime;
+	t.HighPart = ft.dwHighDateTime;
+	t.QuadPart += (long long)(seconds * 1e7);		// FILETIME is in 100ns units
+	FILETIME result;
+	result.dwLowDateTime = t.LowPart;
+	result.dwHighDateTime = t.HighPart;
+	return result;
 }
 
 String Logger::formatFileTime(FILETIME ft) {
+	char tmCharArray[30] = { 0 };
+	formatFileTime(ft, tmCharArray, sizeof(tmCharArray));
+	std::string timeStr(tmCharArray);
+	return String(timeStr);
+}
+
+int Logger::formatFileTime(FILETIME ft, char* out, size_t size) {
 	unsigned long long usecsinceepoch = (static_cast<unsigned long long>(ft.dwHighDateTime) << 32 | ft.dwLowDateTime) / 10;		// Get time since epoch in usec
 	int usec = usecsinceepoch % 1000000;
 
 	SYSTEMTIME datetime;
 	FileTimeToSystemTime(&ft, &datetime);
 
-	char tmCharArray[30] = { 0 };
-	sprintf(tmCharArray, "%04d-%02d-%02d %02d:%02d:%02d.%06d", datetime.wYear, datetime.wMonth, datetime.wDay, datetime.wHour, datetime.wMinute, datetime.wSecond, usec);
-	std::string timeStr(tmCharArray);
-	return String(timeStr);
+	return snprintf(out, size, "%04d-%02d-%02d %02d:%02d:%02d.%06d", datetime.wYear, datetime.wMonth, datetime.wDay, datetime.wHour, datetime.wMinute, datetime.wSecond, usec);
+}
+
+/** Append printf style formatted text to an SQL statement */
+static void appendSql(ArenaString& sql, const char* fmt, ...) {
+	char buf[512];
+	va_list args;
+	va_start(args, fmt);
+	const int n = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	if (n < (int)sizeof(buf)) {
+		sql.append(buf, n);
+		return;
+	}
+	// Too long for the stack buffer, format in place
+	const size_t start = sql.size();
+	sql.resize(start + n);
+	va_start(args, fmt);
+	vsnprintf(&sql[start], n + 1, fmt, args);
+	va_end(args);
 }
 
 
@@ -136,8 +170,18 @@ void Logger::createResultsFile(String filename, String subjectID, String session
 	// 6. Frame_Info, create the table
 	Columns frameInfoColumns = {
 			{"time", "text"},
-			//{"idt", "real"},
+			{"idt", "real"},
 			{"sdt", "real"},
+			{"frame_index", "integer"},
+			{"rdt", "real"},
+			{"user_input_time", "real"},
+			{"simulation_time", "real"},
+			{"pose_time", "real"},
+			{"wait_time", "real"},
+			{"graphics_time", "real"},
+			{"input_to_submit_time", "real"},
+			{"predicted_cost", "real"},
+			{"actual_cost", "real"},
 	};
 	createTableInDB(m_db, "Frame_Info", frameInfoColumns);
 
@@ -165,25 +209,85 @@ void Logger::createResultsFile(String filename, String subjectID, String session
 		{"turnScaleY", "real"}
 	};
 	createTableInDB(m_db, "Users", userColumns);
+
+	// 9. Target_Motion (closed-form motion segments for jumping targets)
+	Columns targetMotionColumns = {
+		{"target_id", "text"},
+		{"start_time", "real"},
+		{"duration", "real"},
+		{"end_events", "integer"},
+		{"space", "text"},
+		{"in_jump", "text"},
+		{"height", "real"},
+		{"jump_speed", "real"},
+		{"gravity", "real"},
+		{"origin_x", "real"},
+		{"origin_y", "real"},
+		{"origin_z", "real"},
+		{"velocity_x", "real"},
+		{"velocity_y", "real"},
+		{"velocity_z", "real"},
+		{"orbit_center_x", "real"},
+		{"orbit_center_y", "real"},
+		{"orbit_center_z", "real"},
+		{"orbit_radius", "real"},
+		{"planar_radius", "real"},
+		{"angle", "real"},
+		{"planar_speed", "real"},
+		{"planar_acc", "real"},
+		{"planar_speed_goal", "real"}
+	};
+	createTableInDB(m_db, "Target_Motion", targetMotionColumns);
+
+	// 10. Frame_Pacing (frame wake-up error histogram, per session)
+	Columns framePacingColumns = {
+		{"session_id", "text"},
+		{"pacing_mode", "text"},
+		{"frame_rate", "real"},
+		{"spin_margin_ms", "real"},
+		{"bin_lower_us", "real"},
+		{"bin_upper_us", "real"},
+		{"count", "integer"}
+	};
+	createTableInDB(m_db, "Frame_Pacing", framePacingColumns);
+
+	// 11. Frame_Stats (measured frame time statistics, per session)
+	Columns frameStatsColumns = {
+		{"session_id", "text"},
+		{"frames", "integer"},
+		{"mean_ms", "real"},
+		{"min_ms", "real"},
+		{"p50_ms", "real"},
+		{"p95_ms", "real"},
+		{"p99_ms", "real"},
+		{"max_ms", "real"}
+	};
+	createTableInDB(m_db, "Frame_Stats", frameStatsColumns);
 }
 
+// The record methods below build their (multi-row) insert statements directly in the drain arena rather than going through RowEntry arrays
 void Logger::recordFrameInfo(const Array<FrameInfo>& frameInfo) {
-	Array<RowEntry> rows;
-	for (FrameInfo info : frameInfo) {
-		Array<String> frameValues = {
-			"'" + Logger::formatFileTime(info.time) + "'",
-			//String(std::to_string(info.idt)),
-			String(std::to_string(info.sdt))
-		};
-		rows.append(frameValues);
+	if (frameInfo.size() == 0) return;
+	ArenaString sql("INSERT INTO Frame_Info VALUES", ArenaAllocator<char>(m_drainArena.get()));
+	char time[30];
+	for (int i = 0; i < frameInfo.size(); i++) {
+		const FrameInfo& info = frameInfo[i];
+		formatFileTime(info.time, time, sizeof(time));
+		appendSql(sql, "%s('%s',%f,%f,%llu,%f,%f,%f,%f,%f,%f,%f,%f,%f)", (i > 0) ? "," : "", time, info.idt, info.sdt, (unsigned long long)info.frameIndex,
+			info.rdt, info.userInputTime, info.simulationTime, info.poseTime, info.waitTime, info.graphicsTime, info.inputToSubmitTime,
+			info.predictedCost, info.actualCost);
 	}
-	insertRowsIntoDB(m_db, "Frame_Info", rows);
+	sql += ";";
+	sql_stmt(m_db, sql.c_str());
 }
 
 void Logger::recordPlayerActions(const Array<PlayerAction>& actions) {
-	Array<RowEntry> rows;
-	for (PlayerAction action : actions) {
-		String actionStr = "";
+	if (actions.size() == 0) return;
+	ArenaString sql("INSERT INTO Player_Action VALUES", ArenaAllocator<char>(m_drainArena.get()));
+	char time[30];
+	for (int i = 0; i < actions.size(); i++) {
+		const PlayerAction& action = actions[i];
+		const char* actionStr = "";
 		switch (action.action) {
 		case Invalid: actionStr = "invalid"; break;
 		case Nontask: actionStr = "non-task"; break;
@@ -192,34 +296,67 @@ void Logger::recordPlayerActions(const Array<PlayerAction>& actions) {
 		case Hit: actionStr = "hit"; break;
 		case Destroy: actionStr = "destroy"; break;
 		}
-		Array<String> playerActionValues = {
-		"'" + Logger::formatFileTime(action.time) + "'",
-		String(std::to_string(action.viewDirection.x)),
-		String(std::to_string(action.viewDirection.y)),
-		String(std::to_string(action.position.x)),
-		String(std::to_string(action.position.y)),
-		String(std::to_string(action.position.z)),
-		"'" + actionStr + "'",
-		"'" + action.targetName + "'",
-		};
-		rows.append(playerActionValues);
+		formatFileTime(action.time, time, sizeof(time));
+		appendSql(sql, "%s('%s',%f,%f,%f,%f,%f,'%s','%s')", (i > 0) ? "," : "", time,
+			action.viewDirection.x, action.viewDirection.y,
+			action.position.x, action.position.y, action.position.z,
+			actionStr, action.targetName.c_str());
 	}
-	insertRowsIntoDB(m_db, "Player_Action", rows);
+	sql += ";";
+	sql_stmt(m_db, sql.c_str());
 }
 
 void Logger::recordTargetLocations(const Array<TargetLocation>& locations) {
-	Array<RowEntry> rows;
-	for (const auto& loc : locations) {
-		Array<String> targetTrajectoryValues = {
-			"'" + Logger::formatFileTime(loc.time) + "'",
-			"'" + loc.name + "'",
-			String(std::to_string(loc.position.x)),
-			String(std::to_string(loc.position.y)),
-			String(std::to_string(loc.position.z)),
-		};
-		rows.append(targetTrajectoryValues);
+	if (locations.size() == 0) return;
+	ArenaString sql("INSERT INTO Target_Trajectory VALUES", ArenaAllocator<char>(m_drainArena.get()));
+	char time[30];
+	for (int i = 0; i < locations.size(); i++) {
+		const TargetLocation& loc = locations[i];
+		formatFileTime(loc.time, time, sizeof(time));
+		appendSql(sql, "%s('%s','%s',%f,%f,%f)", (i > 0) ? "," : "", time, loc.name.c_str(), loc.position.x, loc.position.y, loc.position.z);
 	}
-	insertRowsIntoDB(m_db, "Target_Trajectory", rows);
+	sql += ";";
+	sql_stmt(m_db, sql.c_str());
+}
+
+void Logger::logTargetLocations(const Array<TargetLocation>& targetLocations) {
+	{
+		std::lock_guard<std::mutex> lk(m_queueMutex);
+		m_targetLocations.append(targetLocations);
+	}
+	if (getTotalQueueBytes() >= m_bufferLimit) {
+		m_queueCV.notify_one();
+	}
+}
+
+void Logger::logTargetMotion(const String& name, const JumpSegment& seg) {
+	const RowEntry row = {
+		"'" + name + "'",
+		String(std::to_string(seg.startTime)),
+		String(std::to_string(seg.duration)),
+		String(std::to_string(seg.endEvents)),
+		seg.worldSpace ? "'world'" : "'player'",
+		seg.inJump ? "'True'" : "'False'",
+		String(std::to_string(seg.height0)),
+		String(std::to_string(seg.jumpSpeed)),
+		String(std::to_string(seg.gravity)),
+		String(std::to_string(seg.origin.x)),
+		String(std::to_string(seg.origin.y)),
+		String(std::to_string(seg.origin.z)),
+		String(std::to_string(seg.velocity.x)),
+		String(std::to_string(seg.velocity.y)),
+		String(std::to_string(seg.velocity.z)),
+		String(std::to_string(seg.orbitCenter.x)),
+		String(std::to_string(seg.orbitCenter.y)),
+		String(std::to_string(seg.orbitCenter.z)),
+		String(std::to_string(seg.orbitRadius)),
+		String(std::to_string(seg.planarRadius)),
+		String(std::to_string(seg.angle0)),
+		String(std::to_string(seg.planarSpeed)),
+		String(std::to_string(seg.planarAcc)),
+		String(std::to_string(seg.planarSpeedGoal))
+	};
+	addToQueue(m_targetMotion, row);
 }
 
 void Logger::recordToDb(const Array<RowEntry>& rows, String tableName) {
@@ -232,6 +369,7 @@ void Logger::recordToDb(const Array<RowEntry>& rows, String tableName) {
 
 void Logger::loggerThreadEntry()
 {
+	TraceRecorder::setThreadName("Logger");
 	std::unique_lock<std::mutex> lk(m_queueMutex);
 	while (m_running) {
 
@@ -258,6 +396,16 @@ void Logger::loggerThreadEntry()
 		targetLocations.swap(m_targetLocations, targetLocations);
 		m_targetLocations.reserve(targetLocations.size() * 2);
 
+		decltype(m_targetMotion) targetMotion;
+		targetMotion.swap(m_targetMotion, targetMotion);
+		m_targetMotion.reserve(targetMotion.size() * 2);
+
+		decltype(m_wakeErrors) wakeErrors;
+		wakeErrors.swap(m_wakeErrors, wakeErrors);
+
+		decltype(m_frameStats) frameStats;
+		frameStats.swap(m_frameStats, frameStats);
+
 		decltype(m_targets) targets;
 		targets.swap(m_targets, targets);
 		m_targets.reserve(targets.size() * 2);
@@ -272,6 +420,8 @@ void Logger::loggerThreadEntry()
 
 		// Unlock all the now-empty queues and write out our temporary copies
 		lk.unlock();
+		m_drainArena->reset();
+		TraceRecorder::begin("Logger::write");
 
 		recordFrameInfo(frameInfo);
 		recordPlayerActions(playerActions);
@@ -279,8 +429,12 @@ void Logger::loggerThreadEntry()
 
 		recordToDb(questions, "Questions");
 		recordToDb(targets, "Targets");
+		recordToDb(targetMotion, "Target_Motion");
+		recordToDb(wakeErrors, "Frame_Pacing");
+		recordToDb(frameStats, "Frame_Stats");
 		recordToDb(users, "Users");
 		recordToDb(trials, "Trials");
+		TraceRecorder::end();
 
 		lk.lock();
 	}
@@ -357,6 +511,41 @@ void Logger::addQuestion(Question q, String session) {
 	logQuestionResult(rowContents);
 }
 
+void Logger::logWakeErrors(const String& sessionId, const RenderConfig& render, const WakeErrorHistogram& histogram) {
+	// Unbounded (outer) bin edges are written as NULL
+	auto edge = [](double us) { return isFinite(us) ? String(std::to_string(us)) : String("NULL"); };
+	std::lock_guard<std::mutex> lk(m_queueMutex);
+	for (int i = 0; i < WakeErrorHistogram::NumBins; i++) {
+		m_wakeErrors.append(RowEntry({
+			"'" + sessionId + "'",
+			"'" + render.pacingMode + "'",
+			String(std::to_string(render.frameRate)),
+			String(std::to_string(render.pacingSpinMarginMs)),
+			edge(WakeErrorHistogram::binLowerUs(i)),
+			edge(WakeErrorHistogram::binUpperUs(i)),
+			String(std::to_string(histogram.counts[i]))
+		}));
+	}
+}
+
+void Logger::logFrameStats(const String& sessionId, const SessionFrameStats& stats) {
+	if (stats.count() == 0) return;
+	const float p[3] = { 0.5f, 0.95f, 0.99f };
+	RealTime percentiles[3];
+	stats.histogram.percentiles(p, percentiles, 3);
+	RowEntry row = {
+		"'" + sessionId + "'",
+		String(std::to_string(stats.count())),
+		String(std::to_string(1000.0 * stats.mean())),
+		String(std::to_string(1000.0 * stats.minimum)),
+		String(std::to_string(1000.0 * percentiles[0])),
+		String(std::to_string(1000.0 * percentiles[1])),
+		String(std::to_string(1000.0 * percentiles[2])),
+		String(std::to_string(1000.0 * stats.maximum))
+	};
+	addToQueue(m_frameStats, row);
+}
+
 void Logger::logUserConfig(const UserConfig& user, const String session_ref, const String position) {
 	RowEntry row = {
 		"'" + user.id + "'",
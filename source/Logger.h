@@ -2,6 +2,10 @@
 #include <G3D/G3D.h>
 #include "sqlHelpers.h"
 #include "ConfigFiles.h"
+#include "FrameArena.h"
+#include "FramePacer.h"
+#include "FrameStats.h"
+#include "TraceRecorder.h"
 
 using RowEntry = Array<String>;
 using Columns = Array<Array<String>>;
@@ -39,16 +43,24 @@ protected:
 	Array<PlayerAction> m_playerActions;				///< Storage for player action (hit, miss, aim)
 	Array<QuestionResult> m_questions;
 	Array<TargetLocation> m_targetLocations;			///< Storage for target trajectory (vector3 cartesian)
+	Array<RowEntry> m_targetMotion;						///< Storage for closed-form target motion segments
+	Array<RowEntry> m_wakeErrors;						///< Storage for frame wake-up error histogram bins
+	Array<RowEntry> m_frameStats;						///< Storage for per session frame time statistics
 	Array<TargetInfo> m_targets;
 	Array<TrialValues> m_trials;						///< Trial ID, start/end time etc.
 	Array<UserValues> m_users;
 
+	shared_ptr<FrameArena> m_drainArena = FrameArena::create(256 * 1024);	///< Scratch memory for building SQL (reset each time the queues are written out)
+
 	size_t getTotalQueueBytes()
 	{
 		return queueBytes(m_frameInfo) +
 			queueBytes(m_playerActions) +
 			queueBytes(m_questions) +
 			queueBytes(m_targetLocations) +
+			queueBytes(m_targetMotion) +
+			queueBytes(m_wakeErrors) +
+			queueBytes(m_frameStats) +
 			queueBytes(m_targets) +
 			queueBytes(m_trials);
 	}
@@ -100,11 +112,19 @@ public:
 	void logPlayerAction(const PlayerAction& playerAction) { addToQueue(m_playerActions, playerAction); }
 	void logQuestionResult(const QuestionResult& questionResult) { addToQueue(m_questions, questionResult); }
 	void logTargetLocation(const TargetLocation& targetLocation) { addToQueue(m_targetLocations, targetLocation); }
+	void logTargetLocations(const Array<TargetLocation>& targetLocations);
+	void logTargetMotion(const String& name, const JumpSegment& segment);
 	void logTargetInfo(const TargetInfo& targetInfo) { addToQueue(m_targets, targetInfo); }
 	void logTrial(const TrialValues& trial) { addToQueue(m_trials, trial); }
 
 	void logUserConfig(const UserConfig& userConfig, const String session_ref, const String position);
 
+	/** Record a session's frame wake-up error histogram (one row per bin) */
+	void logWakeErrors(const String& sessionId, const RenderConfig& render, const WakeErrorHistogram& histogram);
+
+	/** Record a session's (measured) frame time statistics */
+	void logFrameStats(const String& sessionId, const SessionFrameStats& stats);
+
 	/** Wakes up the logging thread and flushes even if the buffer limit is not reached yet. */
 	void flush(bool blockUntilDone);
 	
@@ -112,7 +132,10 @@ public:
 	static String genUniqueTimestamp();
 
 	static FILETIME getFileTime();
+	static FILETIME offsetFileTime(FILETIME ft, double seconds);
 	static String formatFileTime(FILETIME ft);
+	/** Format a timestamp into out (w/o allocating), returns the number of characters written */
+	static int formatFileTime(FILETIME ft, char* out, size_t size);
 
 	/** Genearte a timestamp for filenames */
 	static String genFileTimestamp();
@@ -1,5 +1,6 @@
 #include "PhysicsScene.h"
 #include "PlayerEntity.h"
+#include "CollisionCache.h"
 
 shared_ptr<PhysicsScene> PhysicsScene::create(const shared_ptr<AmbientOcclusion>& ao) {
     return createShared<PhysicsScene>(ao);
@@ -33,20 +34,54 @@ Any PhysicsScene::load(const String& sceneName, const LoadOptions& loadOptions)
 		physicsTable.getIfPresent("minHeight", m_resetHeight);
     }
     
-    // Set the initial positions
-	float minHeight = 1e6;
-    Array<shared_ptr<Surface>> collisionSurfaces;
-    for (int e = 0; e < m_entityArray.size(); ++e) {
-        shared_ptr<VisibleEntity> entity = dynamic_pointer_cast<VisibleEntity>(m_entityArray[e]);
-		if (notNull(entity)) {
-			if (!entity->canChange()) {
-				entity->onSimulation(0, 0);
-				entity->onPose(collisionSurfaces);
+	buildCollisionTree(CollisionCache::sceneKey(sceneNameToFilename(sceneName), resultAny));
+	m_collisionTreeVersion++;
+    return resultAny;
+}
+
+void PhysicsScene::buildCollisionTree(uint64 key) {
+	// Reuse the tree if this scene was loaded recently
+	const shared_ptr<TriTree>* cached = m_treeCache.getPointer(key);
+	if (notNull(cached)) {
+		m_collisionTree = *cached;
+		return;
+	}
+
+	Array<Tri> triArray;
+	CPUVertexArray vertexArray;
+	const bool useDiskCache = !m_collisionCachePath.empty();
+	if (!useDiskCache || !CollisionCache::load(m_collisionCachePath, key, triArray, vertexArray)) {
+		// Set the initial positions
+		Array<shared_ptr<Surface>> collisionSurfaces;
+		for (int e = 0; e < m_entityArray.size(); ++e) {
+			shared_ptr<VisibleEntity> entity = dynamic_pointer_cast<VisibleEntity>(m_entityArray[e]);
+			if (notNull(entity)) {
+				if (!entity->canChange()) {
+					entity->onSimulation(0, 0);
+					entity->onPose(collisionSurfaces);
+				}
 			}
 		}
-    }
-    m_collisionTree->setContents(collisionSurfaces, IMAGE_STORAGE_CURRENT);
-    return resultAny;
+		Surface::getTris(collisionSurfaces, vertexArray, triArray);
+		CollisionCache::toCollisionGeometry(triArray, vertexArray);		// Drop the materials, as a cache hit would
+		if (useDiskCache) {
+			CollisionCache::save(m_collisionCachePath, key, triArray, vertexArray);
+		}
+	}
+
+	// Cached trees are shared, so build into a new one
+	m_collisionTree = TriTree::create(false);
+	m_collisionTree->setContents(triArray, vertexArray, IMAGE_STORAGE_CURRENT);
+	addCollisionTree(key, m_collisionTree);
+}
+
+void PhysicsScene::addCollisionTree(uint64 key, const shared_ptr<TriTree>& tree) {
+	if (m_treeCache.containsKey(key)) return;
+	if (m_treeCacheOrder.size() >= MaxCachedTrees) {
+		m_treeCache.remove(m_treeCacheOrder.dequeue());
+	}
+	m_treeCache.set(key, tree);
+	m_treeCacheOrder.enqueue(key);
 }
 
 void PhysicsScene::staticIntersectSphere(const Sphere& sphere, Array<Tri>& triArray) const {
@@ -61,3 +96,11 @@ void PhysicsScene::staticIntersectBox(const AABox& box, Array<Tri>& triArray) co
     }
 }
 
+float PhysicsScene::staticIntersectRay(const Ray& ray) const {
+    TriTree::Hit hit;
+    if (m_collisionTree && m_collisionTree->intersectRay(ray, hit)) {
+        return hit.distance;
+    }
+    return finf();
+}
+
@@ -5,20 +5,37 @@ class PhysicsScene : public Scene {
 protected:
     Vector3 m_gravity;
 	float m_resetHeight = fnan();
+	uint32 m_collisionTreeVersion = 0;		///< Incremented each time the collision tree is rebuilt
 
     /** Polygons of all non-dynamic entitys */
     shared_ptr<TriTree>                     m_collisionTree;
 
+	String		m_collisionCachePath;				///< Directory for cached collision geometry (empty to disable the cache)
+	static const int MaxCachedTrees = 4;			///< Most collision trees kept in memory (for switching back to a scene)
+	Table<uint64, shared_ptr<TriTree>>		m_treeCache;		///< Built collision trees by scene key
+	Queue<uint64>							m_treeCacheOrder;	///< Keys in m_treeCache (oldest first)
+
     PhysicsScene(const shared_ptr<AmbientOcclusion>& ao) : Scene(ao) {
         m_collisionTree = TriTree::create(false);
     }
 
+	/** Build the collision tree from the static entities (or the collision cache) for the scene w/ the given key */
+	void buildCollisionTree(uint64 key);
+
 public:
 
     static shared_ptr<PhysicsScene> create(const shared_ptr<AmbientOcclusion>& ao);
 
+	/** Add a (prebuilt) collision tree to the in memory cache, evicting the oldest tree if it is full */
+	void addCollisionTree(uint64 key, const shared_ptr<TriTree>& tree);
+
     void poseExceptExcluded(Array<shared_ptr<Surface> >& surfaceArray, const String& excludedEntity);
 
+	/** Set the directory used to cache collision geometry across runs (empty disables the cache) */
+	void setCollisionCachePath(const String& path) {
+		m_collisionCachePath = path;
+	}
+
     void setGravity(const Vector3& newGravity) {
         m_gravity = newGravity;
     }
@@ -40,10 +57,23 @@ public:
     /** Gets all static triangles within this world-space box. */
     void staticIntersectBox(const AABox& box, Array<Tri>& triArray) const;
 
+    /** Distance along the ray to the closest static triangle (finf() if there isn't one) */
+    float staticIntersectRay(const Ray& ray) const;
+
     const CPUVertexArray& vertexArrayOfCollisionTree() const {
         return m_collisionTree->vertexArray();
     }
 
+	/** The static collision tree, replaced (not modified) when it is rebuilt, so a reference stays valid for queries from other threads */
+	shared_ptr<TriTree> collisionTree() const {
+		return m_collisionTree;
+	}
+
+	/** Changes whenever the collision tree is rebuilt (i.e. on scene load), used to invalidate cached triangles */
+	uint32 collisionTreeVersion() const {
+		return m_collisionTreeVersion;
+	}
+
      Any toAny() const;
 
 };
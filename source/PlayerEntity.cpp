@@ -1,5 +1,6 @@
 #include "PlayerEntity.h"
 #include "PhysicsScene.h"
+#include "SimClock.h"
 
 // Disable collisions
 // #define NO_COLLISIONS
@@ -75,6 +76,26 @@ void PlayerEntity::init(const Vector3& velocity, const Sphere& collisionProxy, f
     m_headTilt              = 0;
 }
 
+Vector3 PlayerEntity::gravity() const {
+	return notNull(m_motionCollisionTree) ? m_motionGravity : ((PhysicsScene*)m_scene)->gravity();
+}
+
+shared_ptr<PlayerEntity> PlayerEntity::copyMotion() const {
+	const PhysicsScene* scene = (PhysicsScene*)m_scene;
+	const shared_ptr<PlayerEntity>& copy = createShared<PlayerEntity>(*this);
+	copy->m_externalMotion = false;
+	copy->m_motionUpdated = false;
+	copy->m_snapPending = false;
+	copy->m_scratchMemory = nullptr;			// The frame arena belongs to the main thread
+	// The copy poses itself (in onSimulation()), so it can't share the live player's poses
+	if (notNull(m_pose)) copy->m_pose = m_pose->clone();
+	if (notNull(m_previousPose)) copy->m_previousPose = m_previousPose->clone();
+	copy->m_motionCollisionTree = scene->collisionTree();
+	copy->m_motionCollisionTreeVersion = scene->collisionTreeVersion();
+	copy->m_motionGravity = scene->gravity();
+	return copy;
+}
+
 bool PlayerEntity::doDamage(float damage) {
 	m_health -= damage;
 	return m_health <= 0;
@@ -93,34 +114,48 @@ void PlayerEntity::onPose(Array<shared_ptr<Surface> >& surfaceArray) {
 }
 
 void PlayerEntity::updateFromInput(UserInput* ui) {
+	updateFromInput(Vector2(ui->getX(), ui->getY()), ui->mouseDXY(), SimClock::time());
+}
+
+void PlayerEntity::updateFromInput(const Vector2& move, const Vector2& mouseDXY, SimTime time) {
 
 	const float walkSpeed = *moveRate * units::meters() / units::seconds();
 
 	// Get walking speed here (and normalize if necessary)
-	Vector3 linear = Vector3(ui->getX()*moveScale->x, 0, -ui->getY()*moveScale->y);
+	Vector3 linear = Vector3(move.x*moveScale->x, 0, -move.y*moveScale->y);
 	if (linear.magnitude() > 0) {
 		linear = linear.direction() * walkSpeed;
 	}
+	// Keep a jump the simulation hasn't consumed yet (frames can run w/o a simulation step)
+	linear.y = max(m_desiredOSVelocity.y, 0.0f);
 	// Add jump here (if needed)
-	RealTime timeSinceLastJump = System::time() - m_lastJumpTime;
+	RealTime timeSinceLastJump = time - m_lastJumpTime;
 	if (m_jumpPressed && timeSinceLastJump > *jumpInterval) {
 		// Allow jumping if jumpTouch = False or if jumpTouch = True and the player is in contact w/ the map
 		if (!(*jumpTouch) || m_inContact) {
 			const Vector3 jv(0, *jumpVelocity * units::meters() / units::seconds(), 0);
 			linear += jv;
-			m_lastJumpTime = System::time();
+			m_lastJumpTime = time;
 		}
 	}
 	m_jumpPressed = false;
 
+	// Set the player translation velocity, apply the rotation now (view latency shouldn't depend on the simulation rate)
+	setDesiredOSVelocity(linear);
+	setDesiredAngularVelocity(0.0f, 0.0f);
+	updateView(mouseDXY);
+}
+
+void PlayerEntity::updateViewFromInput(UserInput* ui) {
+	updateView(ui->mouseDXY());
+}
+
+void PlayerEntity::updateView(const Vector2& mouseDXY) {
 	// Get the mouse rotation here
-	Vector2 mouseRotate = ui->mouseDXY() * turnScale * (float)mouseSensitivity / 2000.0f;
+	Vector2 mouseRotate = mouseDXY * turnScale * (float)mouseSensitivity / 2000.0f;
 	float yaw = mouseRotate.x;
 	float pitch = mouseRotate.y;
-
-	// Set the player translation/view velocities
-	setDesiredOSVelocity(linear);
-	setDesiredAngularVelocity(yaw, pitch);
+	setView(m_headingRadians + yaw, m_headTilt - pitch);
 }
 
 /** Maximum coordinate values for the player ship */
@@ -129,6 +164,18 @@ void PlayerEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
     if (! isNaN(deltaTime) && (deltaTime > 0)) {
         m_previousFrame = m_frame;
     }
+	if (m_externalMotion) {
+		// Commit the position simulated elsewhere (the view is turned on the main thread)
+		if (m_motionUpdated) {
+			m_frame.translation = m_pendingPosition;
+			if (m_snapPending) {
+				m_previousFrame = m_frame;
+			}
+			m_motionUpdated = false;
+			m_snapPending = false;
+		}
+		return;
+	}
     simulatePose(absoluteTime, deltaTime);
 
 	if (!isNaN(deltaTime)) {
@@ -145,15 +192,38 @@ void PlayerEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
 	}
 }
 
-void PlayerEntity::getConservativeCollisionTris(Array<Tri>& triArray, const Vector3& velocity, float deltaTime) const {
+const CollisionTriangles& PlayerEntity::getConservativeCollisionTris(const Vector3& velocity, float deltaTime) {
     Sphere nearby = collisionProxy();
     nearby.radius += velocity.length() * deltaTime;
-    ((PhysicsScene*)m_scene)->staticIntersectSphere(nearby, triArray);
+
+	// Reuse the cached triangles while the query sphere stays inside the cache sphere
+	const PhysicsScene* scene = (PhysicsScene*)m_scene;
+	const uint32 treeVersion = notNull(m_motionCollisionTree) ? m_motionCollisionTreeVersion : scene->collisionTreeVersion();
+	const bool cacheValid = (m_collisionCacheVersion == treeVersion) &&
+		((nearby.center - m_collisionCacheSphere.center).length() + nearby.radius <= m_collisionCacheSphere.radius);
+	if (!cacheValid) {
+		m_collisionCacheSphere = Sphere(nearby.center, nearby.radius + m_collisionCachePadding);
+		Array<Tri> triArray;
+		if (notNull(m_scratchMemory)) {
+			triArray.clearAndSetMemoryManager(m_scratchMemory);
+		}
+		// Store the triangles in world space so collision tests don't need to look up vertices
+		if (notNull(m_motionCollisionTree)) {
+			m_motionCollisionTree->intersectSphere(m_collisionCacheSphere, triArray);
+			m_collisionTris.set(triArray, m_motionCollisionTree->vertexArray());
+		}
+		else {
+			scene->staticIntersectSphere(m_collisionCacheSphere, triArray);
+			m_collisionTris.set(triArray, scene->vertexArrayOfCollisionTree());
+		}
+		m_collisionCacheVersion = treeVersion;
+	}
+	return m_collisionTris;
 }
 
 
 bool PlayerEntity::findFirstCollision
-(const Array<Tri>&    triArray,
+(const CollisionTriangles& triArray,
 	const Vector3&       velocity,
 	float&               stepTime,
 	Vector3&             collisionNormal,
@@ -161,11 +231,16 @@ bool PlayerEntity::findFirstCollision
 
 	bool collision = false;
 	const Sphere& startSphere = collisionProxy();
-	for (int t = 0; t < triArray.size(); ++t) {
 
-		const Tri& tri = triArray[t];
-		const CPUVertexArray& cpuVertexArray = ((PhysicsScene*)m_scene)->vertexArrayOfCollisionTree();
-		Triangle triangle(tri.position(cpuVertexArray, 0), tri.position(cpuVertexArray, 1), tri.position(cpuVertexArray, 2));
+	// Only run the exact test on the triangles that survive the batched cull
+	Array<int> candidates;
+	if (notNull(m_scratchMemory)) {
+		candidates.clearAndSetMemoryManager(m_scratchMemory);
+	}
+	triArray.sweptSphereCandidates(startSphere, velocity, stepTime, candidates);
+	for (int t = 0; t < candidates.size(); ++t) {
+
+		const Triangle& triangle = triArray[candidates[t]];
 		Vector3 C;
 		const float d =
 			CollisionDetection::collisionTimeForMovingSphereFixedTriangle
@@ -220,10 +295,10 @@ bool PlayerEntity::slideMove(SimTime deltaTime) {
 	Point3 loc;
 
 	// Only allow y-axis gravity for now
-    alwaysAssertM(((PhysicsScene*)m_scene)->gravity().x == 0.0f && ((PhysicsScene*)m_scene)->gravity().z == 0.0f, 
+    alwaysAssertM(gravity().x == 0.0f && gravity().z == 0.0f, 
                             "We assume gravity points along the y axis to simplify implementation");
 	alwaysAssertM(axisLock->size() == 3, "Player axis lock must have length 3!");
-	float ygrav = ((PhysicsScene*)m_scene)->gravity().y;
+	float ygrav = gravity().y;
 	Vector3 velocity = frame().vectorToWorldSpace(m_desiredOSVelocity);
 	velocity.x = (*axisLock)[0] ? 0.0f : velocity.x;
 	velocity.y = (*axisLock)[1] ? 0.0f : velocity.y;
@@ -234,6 +309,7 @@ bool PlayerEntity::slideMove(SimTime deltaTime) {
 		m_inAir = true;
 		// Jump occurring, need to track this
 		m_lastJumpVelocity = m_desiredOSVelocity.y;
+		m_desiredOSVelocity.y = 0.0f;			// Jumps are an impulse, consume it so it applies to a single step
 		}
 	else if (m_inAir) {
 		// Already in a jump, apply gravity and enforce terminal velocity
@@ -250,8 +326,7 @@ bool PlayerEntity::slideMove(SimTime deltaTime) {
 		velocity.y = -epsilon;
 	}
 	
-    Array<Tri> triArray;
-    getConservativeCollisionTris(triArray, velocity, (float)deltaTime);
+    const CollisionTriangles& triArray = getConservativeCollisionTris(velocity, (float)deltaTime);
     
     // Trivial implementation that ignores collisions:
 #   if NO_COLLISIONS
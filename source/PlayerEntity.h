@@ -1,5 +1,6 @@
 #pragma once
 #include <G3D/G3D.h>
+#include "CollisionTriangles.h"
 
 class PlayerEntity : public VisibleEntity {
 protected:
@@ -30,6 +31,29 @@ protected:
 	bool			m_motionEnable = true;				///< Flag to disable player motion
 	bool			m_jumpPressed = false;				///< Indicates whether jump buton was pressed
 
+	shared_ptr<MemoryManager>	m_scratchMemory;		///< Memory for per-step temporaries (i.e. a frame arena), nullptr to use the heap
+
+	// Collision triangle cache (reused until the player leaves the cache sphere)
+	CollisionTriangles	m_collisionTris;				///< Static (world-space) triangles within m_collisionCacheSphere
+	Sphere			m_collisionCacheSphere;				///< Padded sphere the cached triangles were queried for
+	uint32			m_collisionCacheVersion = 0;		///< Collision tree version the cache was built from (0 if never built)
+	float			m_collisionCachePadding = 1.0f;		///< Padding added to the query sphere when (re)building the cache (in meters)
+
+	// External motion (see SimulationThread)
+	bool			m_externalMotion = false;			///< Movement is simulated elsewhere, onSimulation() only commits positions from setMotionResult()
+	uint32			m_motionEpoch = 0;					///< Incremented when the player is moved directly (respawn), so external copies know to refresh
+	bool			m_motionUpdated = false;			///< Is there a position from setMotionResult() to commit?
+	bool			m_snapPending = false;				///< Don't interpolate to the pending position (it is a respawn)
+	Point3			m_pendingPosition;
+
+	// Motion copies (see copyMotion()) keep the scene state they move against, the main thread may replace the scene's
+	shared_ptr<TriTree>	m_motionCollisionTree;			///< Collision tree queried by a motion copy (nullptr for the live player)
+	uint32			m_motionCollisionTreeVersion = 0;	///< Scene collision tree version m_motionCollisionTree is
+	Vector3			m_motionGravity;
+
+	/** Gravity from the scene (or the one captured by a motion copy) */
+	Vector3 gravity() const;
+
     PlayerEntity() {}
 
 #ifdef G3D_OSX
@@ -62,20 +86,26 @@ public:
         slideMove with the current \a velocity, allowing that the
         velocity may be decreased along some axes during movement.
 
+        The triangles are cached for a padded sphere and only requeried
+        once the player leaves it, so the result may include triangles
+        that can't be hit. The returned array is valid until the next call.
+
         Called from slideMove(). */
-    void getConservativeCollisionTris(Array<Tri>& triArray, const Vector3& velocity, float deltaTime) const;
+    const CollisionTriangles& getConservativeCollisionTris(const Vector3& velocity, float deltaTime);
     
     /** Finds the first collision between m_collisionProxySphere
         travelling with \a velocity and the triArray.  Travels for at
         most \a stepTime, and updates \a stepTime with the
         collision time if there is one.  Returns true if there is a
         collision before the end of the original \a stepTime.
+        Triangles are culled against the swept sphere in (SIMD) batches
+        before the exact test.
 
         \param collisionNormal Inward-pointing normal to the sphere at
         the collision time (separating axis).
     */
     bool findFirstCollision
-    (const Array<Tri>&      triArray, 
+    (const CollisionTriangles& triArray, 
      const Vector3&         velocity, 
      float&                 stepTime, 
      Vector3&               collisionNormal,
@@ -103,7 +133,14 @@ public:
     float headTilt() const {
         return m_headTilt;
     }
-	   
+
+	/** Set the view direction directly (heading and tilt in radians), used for scripted input */
+	void setView(float headingRadians, float headTilt) {
+		m_headingRadians = mod1(headingRadians / (2 * pif())) * 2 * pif();
+		m_headTilt = clamp(headTilt, -89.9f * units::degrees(), 89.9f * units::degrees());
+		m_frame.rotation = Matrix3::fromAxisAngle(Vector3::unitY(), -m_headingRadians) * Matrix3::fromAxisAngle(Vector3::unitX(), m_headTilt);
+	}
+
 	void setCrouched(bool crouched) {
 		m_crouched = crouched;
 	};
@@ -112,6 +149,22 @@ public:
 		m_jumpPressed = pressed;
 	}
 
+	/** Take a jump press that hasn't been simulated yet (clearing it) */
+	bool takeJumpPressed() {
+		const bool pressed = m_jumpPressed;
+		m_jumpPressed = false;
+		return pressed;
+	}
+
+	bool crouched() const {
+		return m_crouched;
+	}
+
+	/** Set the memory used for per-step temporaries (e.g. collision triangles), this must stay valid for each simulation step */
+	void setScratchMemory(const shared_ptr<MemoryManager>& memory) {
+		m_scratchMemory = memory;
+	}
+
 	void setMoveEnable(bool enabled) {
 		m_motionEnable = enabled;
 	}
@@ -124,8 +177,14 @@ public:
 		m_respawnHeight = height;
 	}
 
+	bool moveEnabled() const {
+		return m_motionEnable;
+	}
+
 	void respawn() {
 		m_frame.translation = m_respawnPosition;
+		m_previousFrame = m_frame;		// Don't interpolate the camera from the old position
+		m_motionEpoch++;
 	}
 
 	float health(void) {
@@ -174,5 +233,29 @@ public:
     virtual void onPose(Array<shared_ptr<Surface> >& surfaceArray) override;
 	virtual void onSimulation(SimTime absoluteTime, SimTime deltaTime) override;
 	void updateFromInput(UserInput* ui);
+	/** Set the desired velocity from movement axes (x right, y forward, as UserInput::getX()/getY()) and turn the view by mouseDXY, jump timing uses time */
+	void updateFromInput(const Vector2& move, const Vector2& mouseDXY, SimTime time);
+	/** Apply the mouse rotation from input to the view (also done by updateFromInput()) */
+	void updateViewFromInput(UserInput* ui);
+	void updateView(const Vector2& mouseDXY);
+
+	/** Copy of the player's motion state (not inserted into the scene) for simulating movement off the main thread.
+		The copy moves against the scene's current collision tree and gravity, even if the scene is reloaded. Called from the main thread. */
+	shared_ptr<PlayerEntity> copyMotion() const;
+
+	/** Drive this player's movement from outside (i.e. the simulation thread), onSimulation() then only commits positions from setMotionResult() */
+	void setExternalMotion(bool external) { m_externalMotion = external; }
+	bool externalMotion() const { return m_externalMotion; }
+
+	/** Take the position in the next onSimulation() (for externally simulated movement), snap skips interpolating to the position.
+		The view stays w/ the live player (it is turned from input on the main thread). */
+	void setMotionResult(const Point3& position, bool snap) {
+		m_pendingPosition = position;
+		m_snapPending = m_snapPending || snap;
+		m_motionUpdated = true;
+	}
+
+	/** Changes whenever the player is moved directly (respawn) */
+	uint32 motionEpoch() const { return m_motionEpoch; }
 
 };
\ No newline at end of file
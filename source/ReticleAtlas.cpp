@@ -0,0 +1,51 @@
+#include "ReticleAtlas.h"
+
+void ReticleAtlas::pack(const Array<String>& filenames) {
+	Array<shared_ptr<Image>> images;
+	Vector2int32 cellSize(0, 0);
+	for (const String& filename : filenames) {
+		const shared_ptr<Image>& image = Image::fromFile(filename);
+		cellSize = cellSize.max(Vector2int32(image->width(), image->height()));
+		images.append(image);
+	}
+	// Cells (and so the reticle origins) are multiples of the padding, keeping each reticle aligned to the texel blocks of every sampled mip level
+	cellSize.x = (cellSize.x + Padding - 1) / Padding * Padding + 2 * Padding;
+	cellSize.y = (cellSize.y + Padding - 1) / Padding * Padding + 2 * Padding;
+
+	// Pack the reticles into a (roughly) square grid of equally sized cells
+	const int columns = max(1, iCeil(sqrt(float(images.size()))));
+	const int rows = max(1, iCeil(float(images.size()) / float(columns)));
+	m_image = Image::create(columns * cellSize.x, rows * cellSize.y, ImageFormat::RGBA8());
+	m_image->setAll(Color4::clear());
+	m_atlasSize = Vector2(float(m_image->width()), float(m_image->height()));
+
+	m_cells.fastClear();
+	for (int i = 0; i < images.size(); i++) {
+		const Point2int32 origin(Padding + (i % columns) * cellSize.x, Padding + (i / columns) * cellSize.y);
+		const shared_ptr<Image>& image = images[i];
+		// Copy the reticle w/ its edge texels repeated into the gutter
+		for (int y = -Padding; y < image->height() + Padding; y++) {
+			for (int x = -Padding; x < image->width() + Padding; x++) {
+				Color4unorm8 c;
+				image->get(Point2int32(clamp(x, 0, image->width() - 1), clamp(y, 0, image->height() - 1)), c);
+				m_image->set(origin + Point2int32(x, y), c);
+			}
+		}
+		m_cells.append(Rect2D::xywh(float(origin.x), float(origin.y), float(image->width()), float(image->height())));
+	}
+}
+
+void ReticleAtlas::upload() {
+	m_texture = Texture::fromImage("Reticle Atlas", m_image, ImageFormat::RGBA8(), Texture::DIM_2D, true);
+	m_image = nullptr;
+}
+
+void ReticleAtlas::draw(RenderDevice* rd, int index, const Point2& center, float scale, const Color4& color) const {
+	const Rect2D& cell = m_cells[index];
+	const Rect2D bounds = Rect2D::xywh(center - cell.wh() * scale / 2.0f, cell.wh() * scale);
+
+	// Sample the reticle's cell (trilinear, as its own mipmapped texture), stopping at the coarsest level the gutter covers
+	Sampler sampler(WrapMode::CLAMP, InterpolateMode::TRILINEAR_MIPMAP);
+	sampler.maxMipMap = MaxMipLevel;
+	Draw::rect2D(bounds, rd, color, m_texture, sampler, false, Rect2D::xywh(cell.x0y0() / m_atlasSize, cell.wh() / m_atlasSize));
+}
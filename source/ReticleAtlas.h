@@ -0,0 +1,40 @@
+#pragma once
+#include <G3D/G3D.h>
+
+/** All reticles packed into a single (mipmapped) texture, so changing the reticle (e.g. while dragging the reticle slider) never touches the disk.
+	pack() decodes the images into the atlas image (safe to call from a worker thread), upload() creates the texture (main thread).
+	Each reticle is surrounded by a gutter of its own edge texels (as a clamped texture samples) and placed on a MaxMipLevel aligned origin, so the
+	mip levels it is sampled from match those of the reticle's own texture and filtering never reaches a neighboring reticle. */
+class ReticleAtlas : public ReferenceCountedObject {
+protected:
+	static const int			MaxMipLevel = 4;			///< Coarsest mip level sampled (a reticle drawn at 1/16 size)
+	static const int			Padding = 1 << MaxMipLevel;	///< Gutter texels around each reticle (one texel at MaxMipLevel)
+
+	shared_ptr<Image>			m_image;					///< Packed reticles (released once uploaded)
+	shared_ptr<Texture>			m_texture;
+	Array<Rect2D>				m_cells;					///< Texel bounds of each reticle within the atlas
+	Vector2						m_atlasSize;
+
+	ReticleAtlas() {}
+
+public:
+	static shared_ptr<ReticleAtlas> create() {
+		return createShared<ReticleAtlas>();
+	}
+
+	/** Decode and pack the (already resolved) reticle image files, in index order */
+	void pack(const Array<String>& filenames);
+
+	/** Create the atlas texture from the packed image (needs the GL context) */
+	void upload();
+
+	int size() const { return m_cells.size(); }
+
+	/** Size of a reticle (in texels) */
+	Vector2 reticleSize(int index) const { return m_cells[index].wh(); }
+
+	const shared_ptr<Texture>& texture() const { return m_texture; }
+
+	/** Draw a reticle centered at center (scale is relative to its texel size) */
+	void draw(RenderDevice* rd, int index, const Point2& center, float scale, const Color4& color) const;
+};
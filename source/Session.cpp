@@ -110,7 +110,7 @@ void Session::randomizePosition(const shared_ptr<TargetEntity>& target) const {
 		const CFrame f = CFrame::fromXYZYPRDegrees(initialSpawnPos.x, initialSpawnPos.y, initialSpawnPos.z, rot_yaw - 180.0f/(float)pi()*initialHeadingRadians, rot_pitch, 0.0f);
 		loc = f.pointToWorldSpace(Point3(0, 0, -m_targetDistance));
 	}
-	target->setFrame(loc);
+	target->teleport(loc);
 }
 
 void Session::initTargetAnimation() {
@@ -121,6 +121,7 @@ void Session::initTargetAnimation() {
 
 	// In task state, spawn a test target. Otherwise spawn a target at straight ahead.
 	if (presentationState == PresentationState::task) {
+		Array<shared_ptr<TargetEntity>> spawned;
 		// Iterate through the targets
 		for (int i = 0; i < m_targetConfigs[m_currTrialIdx].size(); i++) {
 			const String name = format("%s_%d_%s_%d", m_config->id, m_currTrialIdx, m_targetConfigs[m_currTrialIdx][i]->id, i);
@@ -135,7 +136,7 @@ void Session::initTargetAnimation() {
 			// Check for case w/ destination array
 			if (target->destinations.size() > 0) {
 				Point3 offset =isWorldSpace ? Point3(0.0, 0.0, 0.0) : f.pointToWorldSpace(Point3(0, 0, -m_targetDistance));
-				m_app->spawnDestTarget(
+				shared_ptr<TargetEntity> t = m_app->spawnDestTarget(
 					offset,
 					target->destinations,
 					visualSize,
@@ -146,6 +147,8 @@ void Session::initTargetAnimation() {
 					name,
 					target->logTargetTrajectory
 				);
+				t->setSpline(target->destSpline);
+				spawned.append(t);
 			}
 			// Otherwise check if this is a jumping target
 			else if (target->jumpEnabled) {
@@ -173,6 +176,7 @@ void Session::initTargetAnimation() {
 				if (isWorldSpace) {
 					t->setBounds(target->bbox);
 				}
+				spawned.append(t);
 			}
 			else {
 				Point3 offset = isWorldSpace ? target->bbox.randomInteriorPoint() : f.pointToWorldSpace(Point3(0, 0, -m_targetDistance));
@@ -195,8 +199,13 @@ void Session::initTargetAnimation() {
 				if (isWorldSpace) {
 					t->setBounds(target->bbox);
 				}
+				spawned.append(t);
 			}
 		}
+
+		if (m_config->timing.bakeTrajectories) {
+			bakeTrajectories(spawned, initialSpawnPos);
+		}
 	}
 	else {
 		Array<bool> locks = { true, true, true };
@@ -221,6 +230,57 @@ void Session::initTargetAnimation() {
 	m_clickCount = 0;
 }
 
+void Session::bakeTrajectories(const Array<shared_ptr<TargetEntity>>& targets, const Point3& origin) {
+	// Copy the motion state of each target (on this thread) so the bake doesn't touch the live entities.
+	// Each copy gets its own Random seeded here (see TargetEntity::copyMotion()), so the bake never draws from Random::common().
+	Array<shared_ptr<TargetEntity>> motions;
+	Array<shared_ptr<TargetTrajectory>> trajectories;
+	for (const shared_ptr<TargetEntity>& target : targets) {
+		const shared_ptr<TargetTrajectory>& trajectory = TargetTrajectory::create(m_config->timing.bakeRate);
+		motions.append(target->copyMotion());
+		trajectories.append(trajectory);
+		target->setTrajectory(trajectory);
+		m_bakedTargets.append(target);
+		m_bakedTrajectories.append(trajectory);
+	}
+	m_bakeOrigin = origin;
+
+	// Bake on a worker, targets whose trajectory isn't ready when they start moving simulate live instead (see TargetEntity::playTrajectory())
+	const SimTime duration = m_config->timing.taskDuration;
+	m_app->jobPool()->runInBackground([motions, trajectories, duration]() {
+		for (int i = 0; i < motions.size(); i++) {
+			trajectories[i]->bake(motions[i], duration);
+		}
+	});
+}
+
+void Session::logBakedTrajectories(bool all) {
+	for (int i = 0; i < m_bakedTargets.size(); i++) {
+		const shared_ptr<TargetEntity> target = m_bakedTargets[i];
+		const shared_ptr<TargetTrajectory> trajectory = m_bakedTrajectories[i];
+		// Wait until playback of this trajectory ends (target destroyed or respawned, or the trial ends)
+		const bool playing = (target->trajectory() == trajectory) && m_app->targetArray.contains(target);
+		if (playing && !all) continue;
+
+		// Only trajectories that were ready (baked) when playback started are played
+		if (m_config->logger.enable && m_config->logger.logTargetTrajectories && target->isLogged() && trajectory->played) {
+			// Write the played part of the trajectory in a single batch
+			const int count = min(iFloor(trajectory->playedUntil * trajectory->sampleRate()) + 1, trajectory->size());
+			Array<TargetLocation> locations;
+			locations.reserve(count);
+			for (int j = 0; j < count; j++) {
+				const FILETIME time = Logger::offsetFileTime(trajectory->playbackStart, j / trajectory->sampleRate());
+				locations.append(TargetLocation(time, target->name(), trajectory->sample(j) - m_bakeOrigin));
+			}
+			m_logger->logTargetLocations(locations);
+		}
+
+		m_bakedTargets.remove(i);
+		m_bakedTrajectories.remove(i);
+		i--;
+	}
+}
+
 void Session::processResponse()
 {
 	m_taskExecutionTime = m_timer.getTime();
@@ -289,6 +349,7 @@ void Session::updatePresentationState()
 		{
 			m_taskEndTime = Logger::genUniqueTimestamp();
 			processResponse();
+			logBakedTrajectories(true);	// write out any trajectories still playing
 			m_app->clearTargets(); // clear all remaining targets
 			newState = PresentationState::feedback;
 			if (m_config->player.stillBetweenTrials) {
@@ -328,6 +389,8 @@ void Session::updatePresentationState()
 				else {
 					if (m_config->logger.enable) {
 						m_logger->logUserConfig(*m_app->getCurrUser(), m_config->id, "end");
+						m_logger->logWakeErrors(m_config->id, m_config->render, m_app->framePacer().wakeErrors());
+						m_logger->logFrameStats(m_config->id, m_app->sessionFrameStats());
 						m_logger->flush(false);
 						m_logger.reset();
 					}
@@ -396,7 +459,6 @@ void Session::onSimulation(RealTime rdt, SimTime sdt, SimTime idt)
 	if (presentationState == PresentationState::task)
 	{
 		accumulateTrajectories();
-		accumulateFrameInfo(rdt, sdt, idt);
 	}
 }
 
@@ -424,6 +486,8 @@ void Session::accumulateTrajectories()
 	if (m_config->logger.logTargetTrajectories) {
 		for (shared_ptr<TargetEntity> target : m_app->targetArray) {
 			if (!target->isLogged()) continue;
+			if (notNull(target->trajectory())) continue;		// Baked trajectories are logged once playback ends
+			if (target->externalMotion()) continue;				// Logged by the simulation thread
 			// recording target trajectories
 			Point3 targetAbsolutePosition = target->frame().translation;
 			Point3 initialSpawnPos = m_app->activeCamera()->frame().translation;
@@ -437,6 +501,20 @@ void Session::accumulateTrajectories()
 			m_logger->logTargetLocation(location);
 		}
 	}
+	logBakedTrajectories(false);
+
+	// Drain (and log) any new closed-form motion segments from jumping targets
+	Array<JumpSegment> segments;
+	for (shared_ptr<TargetEntity> target : m_app->targetArray) {
+		const shared_ptr<JumpingEntity>& jumping = dynamic_pointer_cast<JumpingEntity>(target);
+		if (isNull(jumping)) continue;
+		jumping->takeSegments(segments);
+		if (m_config->logger.logTargetTrajectories && target->isLogged()) {
+			for (const JumpSegment& seg : segments) {
+				m_logger->logTargetMotion(target->name(), seg);
+			}
+		}
+	}
 	// recording view direction trajectories
 	accumulatePlayerAction(PlayerActionType::Aim);
 }
@@ -444,25 +522,32 @@ void Session::accumulateTrajectories()
 void Session::accumulatePlayerAction(PlayerActionType action, String targetName)
 {
 	if (m_config->logger.logPlayerActions) {
-		BEGIN_PROFILER_EVENT("accumulatePlayerAction");
+		BEGIN_TRACE_EVENT("accumulatePlayerAction");
 		// recording target trajectories
 		Point2 dir = m_app->getViewDirection();
 		Point3 loc = m_app->getPlayerLocation();
 		PlayerAction pa = PlayerAction(Logger::getFileTime(), dir, loc, action, targetName);
 		m_logger->logPlayerAction(pa);
-		END_PROFILER_EVENT();
+		END_TRACE_EVENT();
+	}
+}
+
+shared_ptr<Logger> Session::trajectoryLogger() const {
+	if (presentationState != PresentationState::task || isNull(m_config) || !m_config->logger.logTargetTrajectories) {
+		return nullptr;
 	}
+	return m_logger;
 }
 
-void Session::accumulateFrameInfo(RealTime t, float sdt, float idt) {
+void Session::accumulateFrameInfo(const FrameInfo& info) {
 	if (m_config->logger.logFrameInfo) {
-		m_logger->logFrameInfo(FrameInfo(Logger::getFileTime(), sdt));
+		m_logger->logFrameInfo(info);
 	}
 }
 
 bool Session::canFire() {
 	if (isNull(m_config)) return true;
-	double timeNow = System::time();
+	double timeNow = SimClock::time();
 	if ((timeNow - m_lastFireAt) > (m_config->weapon.firePeriod)) {
 		m_lastFireAt = timeNow;
 		return true;
@@ -475,7 +560,7 @@ bool Session::canFire() {
 float Session::weaponCooldownPercent() const {
 	if (isNull(m_config)) return 1.0;
 	if (m_config->weapon.firePeriod == 0.0f) return 1.0;
-	return min((float)(System::time() - m_lastFireAt) / m_config->weapon.firePeriod, 1.0f);
+	return min((float)(SimClock::time() - m_lastFireAt) / m_config->weapon.firePeriod, 1.0f);
 }
 
 int Session::remainingAmmo() const {
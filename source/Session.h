@@ -29,6 +29,7 @@
 
 #include <G3D/G3D.h>
 #include "ConfigFiles.h"
+#include "SimClock.h"
 #include <ctime>
 
 class App;
@@ -40,20 +41,30 @@ class Logger;
 class Timer
 {
 public:
-	std::chrono::steady_clock::time_point startTime;
-	void startTimer() { startTime = std::chrono::steady_clock::now(); };
+	RealTime startTime;
+	void startTimer() { startTime = SimClock::time(); };
 	float getTime()
 	{
-		auto now = std::chrono::steady_clock::now();
-		int t = std::chrono::duration_cast<std::chrono::duration<int, std::milli>>(now - startTime).count();
+		int t = (int)((SimClock::time() - startTime) * 1000.0);		// Truncate to ms
 		return ((float)t) / 1000.0f;
 	};
 };
 
  struct FrameInfo {
-	FILETIME time;
-	//float idt = 0.0f;
-	float sdt = 0.0f;
+	FILETIME time;						///< Time the frame was presented (after the buffer swap)
+	uint64 frameIndex = 0;				///< Frame count since startup
+	float idt = 0.0f;					///< Ideal (target) frame duration
+	float sdt = 0.0f;					///< Simulation time advanced this frame
+	float rdt = 0.0f;					///< Real time elapsed since the last frame
+	// Durations of the oneFrame() phases (in seconds)
+	float userInputTime = 0.0f;
+	float simulationTime = 0.0f;
+	float poseTime = 0.0f;
+	float waitTime = 0.0f;
+	float graphicsTime = 0.0f;
+	float inputToSubmitTime = 0.0f;		///< Time from the (last) input sample used for the view to the end of the frame's GPU submission
+	float predictedCost = 0.0f;			///< Predicted time from the end of the wait to the buffer swap (see FrameScheduler)
+	float actualCost = 0.0f;			///< Measured time from the end of the wait to the buffer swap
 
 	FrameInfo() {};
 
@@ -135,6 +146,11 @@ protected:
 	// Could move timer above to stopwatch in future
 	//Stopwatch stopwatch;			
 
+	// Trajectory baking
+	Array<shared_ptr<TargetEntity>> m_bakedTargets;					///< Targets whose baked trajectories have not been logged yet
+	Array<shared_ptr<TargetTrajectory>> m_bakedTrajectories;		///< Baked trajectories (parallel to m_bakedTargets)
+	Point3 m_bakeOrigin;											///< Spawn position baked trajectories are logged relative to
+
 	// Target parameters
 	const float m_targetDistance = 1.0f;				///< Actual distance to target
 	
@@ -183,7 +199,16 @@ public:
 	void processResponse();
 	void recordTrialResponse(int destroyedTargets, int totalTargets);
 	void accumulateTrajectories();
-	void accumulateFrameInfo(RealTime rdt, float sdt, float idt);
+
+	/** Start baking trajectories for the given (just spawned) targets on a worker thread */
+	void bakeTrajectories(const Array<shared_ptr<TargetEntity>>& targets, const Point3& origin);
+
+	/** Log baked trajectories whose playback has ended (or all of them) to the Target_Trajectory table */
+	void logBakedTrajectories(bool all);
+
+	/** Logger for target trajectories simulated off the main thread (null when trajectories shouldn't be logged now) */
+	shared_ptr<Logger> trajectoryLogger() const;
+	void accumulateFrameInfo(const FrameInfo& info);
 
 	void countDestroy() {
 		m_destroyedTargets += 1;
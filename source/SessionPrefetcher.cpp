@@ -0,0 +1,88 @@
+#include "SessionPrefetcher.h"
+#include "CollisionCache.h"
+#include <cstdio>
+
+void SessionPrefetcher::readAhead(const String& path) {
+	FILE* f = fopen(path.c_str(), "rb");
+	if (isNull(f)) return;
+	static const size_t chunkSize = 1024 * 1024;
+	std::unique_ptr<char[]> buffer(new char[chunkSize]);
+	while (fread(buffer.get(), 1, chunkSize, f) == chunkSize) {}
+	fclose(f);
+}
+
+SessionPrefetcher::SessionPrefetcher(const shared_ptr<SessionConfig>& config, const String& loadedScene, const String& collisionCachePath,
+	AssetCache<GFont>& fontCache, AssetCache<Sound>& soundCache) :
+	m_config(config), m_fontCache(fontCache), m_soundCache(soundCache), m_collisionCachePath(collisionCachePath), m_filesReady(false)
+{
+	for (const String& font : { m_config->hud.hudFont, m_config->targetView.combatTextFont }) {
+		if (!m_fontCache.contains(font)) m_files.append(System::findDataFile(font));
+	}
+	for (const String& sound : { m_config->weapon.fireSound, m_config->audio.explosionSound }) {
+		if (!m_soundCache.contains(sound)) m_files.append(System::findDataFile(sound));
+	}
+	if (m_config->weapon.renderModel) {
+		m_files.append(System::findDataFile(m_config->weapon.modelSpec.filename));
+	}
+
+	// The scene (and its models) only need to be read if the next session changes it
+	if (!m_config->sceneName.empty() && m_config->sceneName != loadedScene) {
+		const String sceneFile = Scene::sceneNameToFilename(m_config->sceneName);
+		const Any sceneAny = Any::fromFile(sceneFile);
+		m_files.append(sceneFile);
+		m_files.append(CollisionCache::modelFiles(sceneAny));
+		m_sceneKey = CollisionCache::sceneKey(sceneFile, sceneAny);
+	}
+
+	m_thread = std::thread(&SessionPrefetcher::threadEntry, this);
+}
+
+SessionPrefetcher::~SessionPrefetcher() {
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+}
+
+void SessionPrefetcher::threadEntry() {
+	for (const String& file : m_files) {
+		readAhead(file);
+	}
+
+	// Build the next scene's collision tree (only possible from the cache, otherwise the scene's entities need to be posed)
+	if (m_sceneKey != 0 && !m_collisionCachePath.empty()) {
+		Array<Tri> triArray;
+		CPUVertexArray vertexArray;
+		if (CollisionCache::load(m_collisionCachePath, m_sceneKey, triArray, vertexArray)) {
+			const shared_ptr<TriTree>& tree = TriTree::create(false);
+			tree->setContents(triArray, vertexArray, IMAGE_STORAGE_CURRENT);
+			m_collisionTree = tree;
+		}
+	}
+	m_filesReady.store(true, std::memory_order_release);
+}
+
+bool SessionPrefetcher::update() {
+	if (!m_filesReady.load(std::memory_order_acquire)) return false;
+	switch (m_stage) {
+	case 0: m_assets.hudFont = m_fontCache.get(m_config->hud.hudFont); break;
+	case 1: m_assets.combatFont = m_fontCache.get(m_config->targetView.combatTextFont); break;
+	case 2: m_assets.fireSound = m_soundCache.get(m_config->weapon.fireSound); break;
+	case 3: m_assets.explosionSound = m_soundCache.get(m_config->audio.explosionSound); break;
+	case 4:
+		if (m_config->weapon.renderModel) {
+			m_assets.viewModel = ArticulatedModel::create(m_config->weapon.modelSpec, "viewModel");
+		}
+		break;
+	default: return true;
+	}
+	m_stage++;
+	return false;
+}
+
+SessionAssets SessionPrefetcher::takeAssets() {
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+	while (!update()) {}
+	return m_assets;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <atomic>
+#include <thread>
+#include "ConfigFiles.h"
+#include "AssetCache.h"
+
+/** Assets loaded when a session starts (see App::updateSession()) */
+struct SessionAssets {
+	shared_ptr<GFont>				hudFont;
+	shared_ptr<GFont>				combatFont;
+	shared_ptr<Sound>				fireSound;
+	shared_ptr<Sound>				explosionSound;
+	shared_ptr<ArticulatedModel>	viewModel;				///< Weapon model (only when the session renders it)
+};
+
+/** Prefetches the next session's assets while the current session shows its feedback/scoreboard.
+	A background thread reads the scene, model, font and sound files (so later loads hit the file cache) and builds the next
+	scene's collision tree from the collision cache. Assets that need the GL context (fonts, models) or the audio system (sounds)
+	are then created on the main thread, one per update(), so no single frame stalls on all of them. Fonts and sounds come from
+	the app's asset caches, so files that are already loaded are neither read ahead nor reloaded. */
+class SessionPrefetcher : public ReferenceCountedObject {
+protected:
+	shared_ptr<SessionConfig>	m_config;
+	SessionAssets				m_assets;
+	AssetCache<GFont>&			m_fontCache;
+	AssetCache<Sound>&			m_soundCache;
+
+	// Resolved on the main thread (file lookup isn't thread safe)
+	Array<String>				m_files;						///< Files to read ahead
+	String						m_collisionCachePath;
+	uint64						m_sceneKey = 0;					///< Collision cache key of the next scene (0 if the scene isn't changing)
+
+	std::thread					m_thread;
+	std::atomic<bool>			m_filesReady;					///< Set once the background thread is done
+	shared_ptr<TriTree>			m_collisionTree;				///< Collision tree for the next scene (written by the thread before m_filesReady)
+	int							m_stage = 0;					///< Next asset to create on the main thread
+
+	SessionPrefetcher(const shared_ptr<SessionConfig>& config, const String& loadedScene, const String& collisionCachePath,
+		AssetCache<GFont>& fontCache, AssetCache<Sound>& soundCache);
+
+	void threadEntry();
+
+public:
+	static shared_ptr<SessionPrefetcher> create(const shared_ptr<SessionConfig>& config, const String& loadedScene, const String& collisionCachePath,
+		AssetCache<GFont>& fontCache, AssetCache<Sound>& soundCache) {
+		return createShared<SessionPrefetcher>(config, loadedScene, collisionCachePath, fontCache, soundCache);
+	}
+
+	virtual ~SessionPrefetcher();
+
+	/** Read through a file (discarding the data) so it is in the OS file cache */
+	static void readAhead(const String& path);
+
+	const String& sessionId() const { return m_config->id; }
+
+	/** Create the next main thread asset (once the background reads are done), returns true once all assets are ready */
+	bool update();
+
+	/** Finish prefetching (blocking) and take the assets */
+	SessionAssets takeAssets();
+
+	/** Collision tree prebuilt for the next scene (or nullptr), w/ its collision cache key. Only valid after takeAssets(). */
+	shared_ptr<TriTree> collisionTree(uint64& key) const {
+		key = m_sceneKey;
+		return m_collisionTree;
+	}
+};
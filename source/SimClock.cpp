@@ -0,0 +1,44 @@
+#include "SimClock.h"
+
+std::atomic<bool> SimClock::s_simulated(false);
+std::atomic<double> SimClock::s_simTime(0.0);
+
+// Simulated clock epoch (2000-01-01 00:00:00 UTC) and the system clock epoch (1970-01-01 00:00:00 UTC) in FILETIME (100ns) units
+static const unsigned long long simEpoch = 125911584000000000ULL;
+static const unsigned long long systemEpoch = 116444736000000000ULL;
+
+typedef std::chrono::duration<long long, std::ratio<1, 10000000>> Ticks;
+
+void SimClock::setSimulated(bool simulated) {
+	s_simTime = 0.0;
+	s_simulated = simulated;
+}
+
+void SimClock::advance(double seconds) {
+	if (s_simulated) {
+		double t = s_simTime.load();
+		while (!s_simTime.compare_exchange_weak(t, t + seconds)) {}
+	}
+}
+
+RealTime SimClock::time() {
+	if (s_simulated) {
+		return s_simTime;
+	}
+	return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint64 SimClock::ticks() {
+	if (s_simulated) {
+		return simEpoch + (unsigned long long)(s_simTime.load() * 1e7);
+	}
+	return systemEpoch + (unsigned long long)std::chrono::duration_cast<Ticks>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+FILETIME SimClock::fileTime() {
+	const uint64 t = ticks();
+	FILETIME ft;
+	ft.dwLowDateTime = uint32(t & 0xFFFFFFFF);
+	ft.dwHighDateTime = uint32(t >> 32);
+	return ft;
+}
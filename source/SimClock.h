@@ -0,0 +1,34 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <atomic>
+#include <chrono>
+
+/** Clock for everything that ends up in the results db (logged timestamps, trial timing, weapon fire period).
+	Reads the system clock (std::chrono::system_clock) by default. In headless mode it is switched to a simulated clock that starts from a
+	fixed epoch and only moves when advance() is called, so runs w/ the same inputs log the same times.
+	The clock is read from the main, simulation and logger threads, so its state is atomic. */
+class SimClock {
+protected:
+	static std::atomic<bool>	s_simulated;		///< Use the simulated clock (instead of the system clock)?
+	static std::atomic<double>	s_simTime;			///< Simulated time (in seconds since the epoch)
+
+public:
+	/** Switch to the simulated clock (reset to the epoch) or back to the system clock */
+	static void setSimulated(bool simulated);
+
+	static bool simulated() {
+		return s_simulated;
+	}
+
+	/** Advance the simulated clock by the given number of seconds (no effect when using the system clock) */
+	static void advance(double seconds);
+
+	/** Current time in seconds (since 1970-01-01 UTC for the system clock, as System::time()) */
+	static RealTime time();
+
+	/** Current time in FILETIME units (100ns ticks since 1601-01-01 UTC) */
+	static uint64 ticks();
+
+	/** Current time as a FILETIME (for logging), see ticks() */
+	static FILETIME fileTime();
+};
@@ -0,0 +1,297 @@
+#include "SimulationThread.h"
+#include "Logger.h"
+#include "SimClock.h"
+#include "TargetEntity.h"
+
+SimulationThread::SimulationThread(float rate) : m_timeStep(1.0 / rate), m_running(true), m_latest(1),
+	m_inputWrite(0), m_inputRead(0), m_hasHandoff(false) {
+	for (int i = 0; i < 3; i++) {
+		m_eye[i] = 0.0f;
+	}
+	m_thread = std::thread(&SimulationThread::threadEntry, this);
+}
+
+SimulationThread::~SimulationThread() {
+	m_running = false;
+	m_thread.join();
+}
+
+void SimulationThread::threadEntry() {
+	const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_timeStep));
+	Clock::time_point next = Clock::now();
+	TraceRecorder::setThreadName("Simulation");
+	while (m_running) {
+		TraceRecorder::begin("SimulationThread::step");
+		step(Clock::now());
+		TraceRecorder::end();
+		next += period;
+		// Skip ahead (rather than run a burst of steps) if we have fallen well behind
+		const Clock::time_point now = Clock::now();
+		if (now - next > 10 * period) {
+			next = now;
+		}
+		std::this_thread::sleep_until(next);
+	}
+}
+
+void SimulationThread::takeHandoff() {
+	{
+		std::lock_guard<std::mutex> lk(m_handoffMutex);
+		if (m_handoffHasTargets) {
+			m_targets = m_handoffTargets;
+			m_version = m_handoffVersion;
+			if (abs(m_time - m_handoffTime) > 0.1) {
+				m_time = m_handoffTime;			// Resync w/ the main thread's timeline (i.e. first handoff, or after a stall)
+			}
+			m_handoffHasTargets = false;
+		}
+		// The replaced player copy and logger are left for the main thread to release
+		if (m_handoffHasPlayer) {
+			m_retiredPlayer = m_player;
+			m_player = m_handoffPlayer;
+			m_handoffPlayer = SimPlayer();
+			m_handoffHasPlayer = false;
+		}
+		if (m_handoffHasLogger) {
+			m_retiredLogger = m_logger;
+			m_logger = m_handoffLogger;
+			m_handoffLogger = nullptr;
+			m_handoffHasLogger = false;
+		}
+		m_hasHandoff = false;
+	}
+	m_handoffTaken.notify_all();
+}
+
+void SimulationThread::step(Clock::time_point now) {
+	if (m_hasHandoff.load(std::memory_order_acquire)) {
+		takeHandoff();
+	}
+
+	m_time += m_timeStep;
+	Snapshot& snapshot = m_snapshots[m_writeIdx];
+	snapshot.time = m_time;
+	snapshot.version = m_version;
+	snapshot.frames.fastClear();
+
+	// Move the player first, so targets are logged relative to where the player is this step
+	Point3 eye(m_eye[0], m_eye[1], m_eye[2]);
+	stepPlayer(now);
+	snapshot.playerVersion = m_player.version;
+	if (notNull(m_player.motion)) {
+		const PlayerEntity& player = *m_player.motion;
+		snapshot.playerEpoch = player.motionEpoch();
+		snapshot.playerPosition = player.frame().translation;
+		eye = player.getCameraFrame().translation;
+	}
+
+	const FILETIME fileTime = Logger::getFileTime();
+	m_locations.fastClear();
+	for (SimTarget& t : m_targets) {
+		t.motion->simulateMotion(m_time, m_timeStep);
+		snapshot.frames.append(t.motion->frame());
+
+		// Drain jumping target motion segments even when not logging (so they don't accumulate)
+		const shared_ptr<JumpingEntity>& jumping = dynamic_pointer_cast<JumpingEntity>(t.motion);
+		if (notNull(jumping)) {
+			jumping->takeSegments(m_segments);
+		}
+		else {
+			m_segments.fastClear();
+		}
+
+		if (notNull(m_logger) && t.logged) {
+			m_locations.append(TargetLocation(fileTime, t.name, t.motion->frame().translation - eye));
+			for (const JumpSegment& seg : m_segments) {
+				m_logger->logTargetMotion(t.name, seg);
+			}
+		}
+	}
+	if (m_locations.size() > 0) {
+		m_logger->logTargetLocations(m_locations);
+	}
+
+	// Publish the snapshot, taking the previously published buffer to write next
+	m_writeIdx = m_latest.exchange(m_writeIdx | FreshBit, std::memory_order_acq_rel) & ~FreshBit;
+}
+
+void SimulationThread::stepPlayer(Clock::time_point now) {
+	// Apply the input sampled up to now, drained even w/o a player so samples don't back up
+	bool jump = false;
+	uint32 read = m_inputRead.load(std::memory_order_relaxed);
+	const uint32 written = m_inputWrite.load(std::memory_order_acquire);
+	while (read != written) {
+		const PlayerInput& input = m_inputQueue[read % InputQueueSize];
+		if (input.time > now) break;
+		m_input = input;
+		jump = jump || input.jump;
+		read++;
+	}
+	m_inputRead.store(read, std::memory_order_release);
+
+	if (isNull(m_player.motion)) return;
+	PlayerEntity& player = *m_player.motion;
+	player.setView(m_input.heading, m_input.tilt);
+	if (jump) {
+		player.setJumpPressed(true);
+	}
+	player.setCrouched(m_input.crouch);
+	player.setMoveEnable(m_input.moveEnabled);
+	player.updateFromInput(m_input.move, Vector2::zero(), SimClock::time());		// Jump timing is on the same clock as the main thread's
+	player.onSimulation(m_time, m_timeStep);
+}
+
+void SimulationThread::waitForHandoff() {
+	SimPlayer retiredPlayer;
+	shared_ptr<Logger> retiredLogger;
+	{
+		std::unique_lock<std::mutex> lk(m_handoffMutex);
+		m_handoffTaken.wait(lk, [this] { return !m_hasHandoff.load(); });
+		std::swap(retiredPlayer, m_retiredPlayer);
+		std::swap(retiredLogger, m_retiredLogger);
+	}
+	// Released here (on the main thread)
+}
+
+void SimulationThread::syncPlayer(const shared_ptr<PlayerEntity>& player, uint32 collisionTreeVersion) {
+	if (notNull(player)) {
+		player->setExternalMotion(true);
+	}
+
+	// Check whether the player (or the scene it moves in) has changed since the last handoff
+	const SimPlayer& prev = m_sentPlayer;
+	const bool changed = notNull(player) ?
+		(prev.player != player) || (prev.epoch != player->motionEpoch()) || (prev.treeVersion != collisionTreeVersion) :
+		notNull(prev.player);
+	if (!changed) return;
+
+	SimPlayer sent;
+	if (notNull(player)) {
+		sent.player = player;
+		sent.epoch = player->motionEpoch();
+		sent.treeVersion = collisionTreeVersion;
+		sent.motion = player->copyMotion();
+		sent.version = ++m_sentPlayerVersion;
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(m_handoffMutex);
+		m_handoffPlayer = sent;
+		m_handoffHasPlayer = true;
+		m_hasHandoff.store(true, std::memory_order_release);
+	}
+	waitForHandoff();
+	m_sentPlayer = sent;
+	m_appliedPlayerEpoch = sent.epoch;
+}
+
+void SimulationThread::submitInput(const shared_ptr<PlayerEntity>& player, const Vector2& move) {
+	PlayerInput input;
+	input.time = Clock::now();
+	input.move = move;
+	input.heading = player->heading();
+	input.tilt = player->headTilt();
+	input.jump = player->takeJumpPressed() || m_unsentJump;
+	input.crouch = player->crouched();
+	input.moveEnabled = player->moveEnabled();
+
+	// Drop the sample if the thread is behind (the next one replaces it), but keep the jump
+	const uint32 written = m_inputWrite.load(std::memory_order_relaxed);
+	if (written - m_inputRead.load(std::memory_order_acquire) >= uint32(InputQueueSize)) {
+		m_unsentJump = input.jump;
+		return;
+	}
+	m_inputQueue[written % InputQueueSize] = input;
+	m_inputWrite.store(written + 1, std::memory_order_release);
+	m_unsentJump = false;
+}
+
+void SimulationThread::syncTargets(const Array<shared_ptr<TargetEntity>>& targets, const shared_ptr<Logger>& logger, const Point3& eye, SimTime time) {
+	for (int i = 0; i < 3; i++) {
+		m_eye[i] = eye[i];
+	}
+
+	// Hand off a new logger and wait for the thread to take it, so the thread never holds (or destroys) a logger the session has finished with
+	if (logger != m_sentLogger) {
+		{
+			std::lock_guard<std::mutex> lk(m_handoffMutex);
+			m_handoffLogger = logger;
+			m_handoffHasLogger = true;
+			m_hasHandoff.store(true, std::memory_order_release);
+		}
+		waitForHandoff();
+		m_sentLogger = logger;
+	}
+
+	// Check whether the live targets (or their motion epochs) have changed since the last handoff
+	bool changed = false;
+	int count = 0;
+	for (const shared_ptr<TargetEntity>& target : targets) {
+		target->setExternalMotion(isNull(target->trajectory()));		// Baked targets still play back on the main thread
+		if (!target->externalMotion()) continue;
+		changed = changed || (count >= m_sent.size()) || (m_sent[count].target != target) || (m_sent[count].epoch != target->motionEpoch());
+		count++;
+	}
+	changed = changed || (count != m_sent.size());
+	if (!changed) return;
+
+	// Keep the motion copies of unchanged targets, copy (new or respawned) targets from their current state
+	Array<SimTarget> sent;
+	for (const shared_ptr<TargetEntity>& target : targets) {
+		if (!target->externalMotion()) continue;
+		SimTarget t;
+		t.target = target;
+		t.epoch = target->motionEpoch();
+		t.name = target->name();
+		t.logged = target->isLogged();
+		for (const SimTarget& prev : m_sent) {
+			if (prev.target == target && prev.epoch == t.epoch) {
+				t.motion = prev.motion;
+				break;
+			}
+		}
+		if (isNull(t.motion)) {
+			t.motion = target->copyMotion();
+			// Segments already started are logged from the live target
+			const shared_ptr<JumpingEntity>& jumping = dynamic_pointer_cast<JumpingEntity>(t.motion);
+			if (notNull(jumping)) {
+				Array<JumpSegment> segments;
+				jumping->takeSegments(segments);
+			}
+		}
+		sent.append(t);
+	}
+
+	// The target set isn't waited on, the thread picks it up at its next step
+	m_sent = sent;
+	m_sentVersion++;
+	{
+		std::lock_guard<std::mutex> lk(m_handoffMutex);
+		m_handoffTargets = sent;
+		m_handoffVersion = m_sentVersion;
+		m_handoffTime = time;
+		m_handoffHasTargets = true;
+		m_hasHandoff.store(true, std::memory_order_release);
+	}
+}
+
+void SimulationThread::applySnapshot() {
+	// Take the latest snapshot if one was published since the last read
+	if (m_latest.load(std::memory_order_acquire) & FreshBit) {
+		m_readIdx = m_latest.exchange(m_readIdx, std::memory_order_acq_rel) & ~FreshBit;
+	}
+	const Snapshot& snapshot = m_snapshots[m_readIdx];
+
+	// The player holds position until the thread has picked up the current copy
+	if (snapshot.playerVersion != 0 && snapshot.playerVersion == m_sentPlayer.version) {
+		const bool respawned = (snapshot.playerEpoch != m_appliedPlayerEpoch);
+		m_sentPlayer.player->setMotionResult(snapshot.playerPosition, respawned);
+		m_appliedPlayerEpoch = snapshot.playerEpoch;
+	}
+
+	// Targets hold position until the thread has picked up the current target set
+	if (snapshot.version != m_sentVersion || snapshot.frames.size() != m_sent.size()) return;
+	for (int i = 0; i < m_sent.size(); i++) {
+		m_sent[i].target->setMotionResult(snapshot.frames[i]);
+	}
+}
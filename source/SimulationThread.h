@@ -0,0 +1,158 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "Session.h"
+#include "PlayerEntity.h"
+
+/** Moves the player, simulates target motion (and logs target trajectories) on a dedicated thread at a fixed, high rate.
+	The thread runs private motion copies of the player and the live targets (see PlayerEntity::copyMotion() and TargetEntity::copyMotion()),
+	the main thread sends it the player and the set of targets when they change (spawn, destroy, respawn) and applies the player position and
+	target frames from the latest snapshot. Input is still taken from window events on the main thread, which sends timestamped input samples
+	through a lock-free queue, each thread step applies the samples taken up to its time.
+	Snapshots are passed through a lock-free triple buffer, the handoff of the player/targets/logger is only locked when one of them changes.
+	Handing off a new player or logger waits for the thread to take it, the thread leaves the old one for the main thread to release. */
+class SimulationThread : public ReferenceCountedObject {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	/** Entity state published by the simulation thread */
+	struct Snapshot {
+		SimTime			time = 0.0;					///< Simulation time of the snapshot
+		uint32			version = 0;				///< Version of the target set the frames belong to
+		Array<CFrame>	frames;						///< Target frames (in target set order)
+		uint32			playerVersion = 0;			///< Version of the player copy the player position belongs to (0 for none)
+		uint32			playerEpoch = 0;			///< Motion epoch of the player copy (changes when it respawns)
+		Point3			playerPosition;
+	};
+
+	/** Player input sampled by the main thread */
+	struct PlayerInput {
+		Clock::time_point	time;					///< When the input was sampled
+		Vector2				move;					///< Movement axes (x right, y forward, as UserInput::getX()/getY())
+		float				heading = 0.0f;			///< View heading (in radians), the main thread turns the view so it responds to the mouse as w/o the thread
+		float				tilt = 0.0f;			///< View tilt (in radians)
+		bool				jump = false;			///< Jump pressed since the last sample
+		bool				crouch = false;
+		bool				moveEnabled = true;		///< See PlayerEntity::setMoveEnable()
+	};
+
+protected:
+	/** A target simulated by the thread */
+	struct SimTarget {
+		shared_ptr<TargetEntity>	target;			///< Live (scene) target, only touched by the main thread
+		uint32						epoch = 0;		///< Motion epoch of the target when the copy was made
+		shared_ptr<TargetEntity>	motion;			///< Motion copy, only touched by the simulation thread once handed off
+		String						name;
+		bool						logged = false;
+	};
+
+	/** The player simulated by the thread */
+	struct SimPlayer {
+		shared_ptr<PlayerEntity>	player;			///< Live (scene) player, only touched by the main thread
+		uint32						epoch = 0;		///< Motion epoch of the player when the copy was made
+		uint32						treeVersion = 0;	///< Collision tree version of the scene when the copy was made
+		shared_ptr<PlayerEntity>	motion;			///< Motion copy, only touched by the simulation thread once handed off
+		uint32						version = 0;	///< Player copy version (0 for none)
+	};
+
+	static const int				FreshBit = 4;				///< Set in m_latest when the buffer hasn't been read yet
+	static const int				InputQueueSize = 64;		///< Input samples the main thread can get ahead of the simulation thread by
+
+	SimTime							m_timeStep;					///< Fixed simulation timestep
+
+	std::thread						m_thread;
+	std::atomic<bool>				m_running;
+
+	// Triple buffered snapshots
+	Snapshot						m_snapshots[3];
+	std::atomic<int>				m_latest;					///< Index of the latest published snapshot (| FreshBit if unread)
+	int								m_writeIdx = 0;				///< Snapshot being written (simulation thread only)
+	int								m_readIdx = 2;				///< Snapshot being read (main thread only)
+
+	// Input queue (main thread -> simulation thread, single producer/single consumer)
+	PlayerInput						m_inputQueue[InputQueueSize];
+	std::atomic<uint32>				m_inputWrite;				///< Samples pushed (written by the main thread)
+	std::atomic<uint32>				m_inputRead;				///< Samples applied (written by the simulation thread)
+
+	// Handoff (main thread -> simulation thread)
+	std::mutex						m_handoffMutex;
+	std::condition_variable			m_handoffTaken;				///< Signalled when the simulation thread has taken the handoff
+	std::atomic<bool>				m_hasHandoff;
+	bool							m_handoffHasTargets = false;
+	Array<SimTarget>				m_handoffTargets;
+	uint32							m_handoffVersion = 0;
+	SimTime							m_handoffTime = 0.0;
+	bool							m_handoffHasPlayer = false;
+	SimPlayer						m_handoffPlayer;
+	bool							m_handoffHasLogger = false;
+	shared_ptr<Logger>				m_handoffLogger;
+	SimPlayer						m_retiredPlayer;			///< Player copy replaced by the last handoff (released by the main thread)
+	shared_ptr<Logger>				m_retiredLogger;			///< Logger replaced by the last handoff (released by the main thread)
+	std::atomic<float>				m_eye[3];					///< Player (eye) position when the thread isn't moving the player, target trajectories are logged relative to this
+
+	// Main thread state
+	Array<SimTarget>				m_sent;						///< Target set last sent to the simulation thread
+	shared_ptr<Logger>				m_sentLogger;
+	uint32							m_sentVersion = 0;
+	SimPlayer						m_sentPlayer;				///< Player last sent to the simulation thread
+	uint32							m_sentPlayerVersion = 0;
+	uint32							m_appliedPlayerEpoch = 0;	///< Player copy motion epoch of the last applied snapshot
+	bool							m_unsentJump = false;		///< Jump press from a sample that didn't fit in the input queue
+
+	// Simulation thread state
+	Array<SimTarget>				m_targets;
+	SimPlayer						m_player;
+	shared_ptr<Logger>				m_logger;					///< Trajectory logger (null when not logging)
+	uint32							m_version = 0;
+	SimTime							m_time = 0.0;
+	Array<TargetLocation>			m_locations;				///< Target locations logged this step
+	Array<JumpSegment>				m_segments;					///< Jumping target motion segments logged this step
+	PlayerInput						m_input;					///< Latest input sample applied
+
+	SimulationThread(float rate);
+
+	void threadEntry();
+
+	/** Simulate one step (at real time now) and publish a snapshot (simulation thread) */
+	void step(Clock::time_point now);
+
+	/** Take the handoff from the main thread (simulation thread) */
+	void takeHandoff();
+
+	/** Move the player copy one step w/ the input sampled up to now (simulation thread) */
+	void stepPlayer(Clock::time_point now);
+
+	/** Wait for the simulation thread to take the handoff, then release the player copy/logger it replaced (main thread) */
+	void waitForHandoff();
+
+public:
+	static shared_ptr<SimulationThread> create(float rate) {
+		return createShared<SimulationThread>(rate);
+	}
+
+	virtual ~SimulationThread();
+
+	SimTime timeStep() const { return m_timeStep; }
+
+	/** Send the player to the simulation thread if it (or its settings, or the scene's collision tree) has changed, marking it as externally simulated.
+		Pass nullptr to take the player off the thread, the thread no longer references the player (or its config) when this returns.
+		Called from the main thread. */
+	void syncPlayer(const shared_ptr<PlayerEntity>& player, uint32 collisionTreeVersion);
+
+	/** Queue the live player's current view, crouch, move enable and pending jump w/ the movement axes for the simulation thread.
+		Called from the main thread (whenever input is sampled) while the player is on the thread. */
+	void submitInput(const shared_ptr<PlayerEntity>& player, const Vector2& move);
+
+	/** Send the live (not baked) targets to the simulation thread if they have changed, marking them as externally simulated.
+		Target trajectories are logged (relative to eye, or the thread's player) to logger, pass nullptr to stop logging. The thread has
+		released the previous logger when this returns, so it is never destroyed on the simulation thread. Called from the main thread. */
+	void syncTargets(const Array<shared_ptr<TargetEntity>>& targets, const shared_ptr<Logger>& logger, const Point3& eye, SimTime time);
+
+	/** Hand the player position and target frames from the latest snapshot to the player and targets (if they are for the current player/target set),
+		they are committed by their next onSimulation(). Called from the main thread. */
+	void applySnapshot();
+};
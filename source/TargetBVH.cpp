@@ -0,0 +1,119 @@
+#include "TargetBVH.h"
+#include "TargetEntity.h"
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TARGET_BVH_SSE 1
+#include <xmmintrin.h>
+#endif
+
+void TargetBVH::rebuild(const Array<shared_ptr<TargetEntity>>& targets) {
+	m_leaves.fastClear();
+	m_spheres.fastClear();
+	m_order.fastClear();
+	if (targets.size() == 0) return;
+
+	// Get the bounding spheres and the extent of their centers
+	AABox centerBounds;
+	for (int i = 0; i < targets.size(); i++) {
+		const Sphere sphere = targets[i]->hitBoundingSphere();
+		m_spheres.append(sphere);
+		m_order.append(i);
+		if (i == 0) centerBounds = AABox(sphere.center);
+		else centerBounds.merge(sphere.center);
+	}
+
+	// Sort along the longest axis so nearby targets share a leaf
+	const Vector3 extent = centerBounds.extent();
+	const int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : ((extent.y >= extent.z) ? 1 : 2);
+	const Array<Sphere>& spheres = m_spheres;
+	std::sort(m_order.begin(), m_order.end(), [&spheres, axis](int a, int b) {
+		return spheres[a].center[axis] < spheres[b].center[axis];
+	});
+
+	// Pack the sorted spheres into leaves
+	for (int first = 0; first < m_order.size(); first += LEAF_SIZE) {
+		Leaf& leaf = m_leaves.next();
+		for (int lane = 0; lane < LEAF_SIZE; lane++) {
+			const int o = first + lane;
+			if (o >= m_order.size()) {
+				// Unused lane, can never be hit
+				leaf.cx[lane] = leaf.cy[lane] = leaf.cz[lane] = 0.0f;
+				leaf.r2[lane] = -1.0f;
+				leaf.index[lane] = -1;
+				continue;
+			}
+			const Sphere& sphere = m_spheres[m_order[o]];
+			const bool hasBounds = sphere.radius > 0.0f;
+			leaf.cx[lane] = sphere.center.x;
+			leaf.cy[lane] = sphere.center.y;
+			leaf.cz[lane] = sphere.center.z;
+			leaf.r2[lane] = hasBounds ? square(sphere.radius) : finf();
+			leaf.index[lane] = m_order[o];
+
+			const AABox box = hasBounds ? AABox(sphere.center - Vector3(sphere.radius, sphere.radius, sphere.radius), sphere.center + Vector3(sphere.radius, sphere.radius, sphere.radius)) : AABox::inf();
+			if (lane == 0) leaf.bounds = box;
+			else leaf.bounds.merge(box);
+		}
+	}
+}
+
+void TargetBVH::intersectRay(const Ray& ray, float maxDistance, Array<Candidate>& candidates) const {
+	candidates.fastClear();
+
+	const Point3& origin = ray.origin();
+	const Vector3& dir = ray.direction();
+#ifdef TARGET_BVH_SSE
+	const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+	const __m128 dx = _mm_set1_ps(dir.x), dy = _mm_set1_ps(dir.y), dz = _mm_set1_ps(dir.z);
+	const __m128 zero = _mm_setzero_ps();
+#endif
+
+	for (const Leaf& leaf : m_leaves) {
+		// Skip the leaf if the ray misses its box
+		if (!leaf.bounds.contains(origin) && isFinite(leaf.bounds.extent().x)) {
+			const float t = ray.intersectionTime(leaf.bounds);
+			if (t > maxDistance) continue;
+		}
+
+		// Ray/sphere test for all lanes: b = dot(c - o, d), disc = b^2 - (|c - o|^2 - r^2)
+		int mask = 0;
+		float dist[LEAF_SIZE];
+#ifdef TARGET_BVH_SSE
+		const __m128 ocx = _mm_sub_ps(_mm_loadu_ps(leaf.cx), ox);
+		const __m128 ocy = _mm_sub_ps(_mm_loadu_ps(leaf.cy), oy);
+		const __m128 ocz = _mm_sub_ps(_mm_loadu_ps(leaf.cz), oz);
+		const __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, dx), _mm_mul_ps(ocy, dy)), _mm_mul_ps(ocz, dz));
+		const __m128 oc2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)), _mm_mul_ps(ocz, ocz));
+		const __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_sub_ps(oc2, _mm_loadu_ps(leaf.r2)));
+		const __m128 s = _mm_sqrt_ps(_mm_max_ps(disc, zero));
+		const __m128 tNear = _mm_max_ps(_mm_sub_ps(b, s), zero);				// Clamp to 0 when starting inside the sphere
+		// Hit if the ray line hits the sphere, the sphere isn't behind the origin, and it is within maxDistance
+		const __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(disc, zero), _mm_cmpge_ps(_mm_add_ps(b, s), zero)),
+			_mm_cmple_ps(tNear, _mm_set1_ps(maxDistance)));
+
+		mask = _mm_movemask_ps(hit);
+		if (mask == 0) continue;
+		_mm_storeu_ps(dist, tNear);
+#else
+		for (int lane = 0; lane < LEAF_SIZE; lane++) {
+			const float ocx = leaf.cx[lane] - origin.x, ocy = leaf.cy[lane] - origin.y, ocz = leaf.cz[lane] - origin.z;
+			const float b = ocx * dir.x + ocy * dir.y + ocz * dir.z;
+			const float disc = b * b - ((ocx * ocx + ocy * ocy + ocz * ocz) - leaf.r2[lane]);
+			const float s = sqrt(max(disc, 0.0f));
+			dist[lane] = max(b - s, 0.0f);
+			if (disc >= 0.0f && b + s >= 0.0f && dist[lane] <= maxDistance) {
+				mask |= 1 << lane;
+			}
+		}
+		if (mask == 0) continue;
+#endif
+		for (int lane = 0; lane < LEAF_SIZE; lane++) {
+			if ((mask & (1 << lane)) && leaf.index[lane] >= 0) {
+				Candidate& c = candidates.next();
+				c.index = leaf.index[lane];
+				c.distance = dist[lane];
+			}
+		}
+	}
+
+	candidates.sort();
+}
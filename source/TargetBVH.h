@@ -0,0 +1,44 @@
+#pragma once
+#include <G3D/G3D.h>
+
+class TargetEntity;
+
+/** Shallow bounding volume hierarchy over target bounding spheres, used to find ray/target hit candidates cheaply.
+	Spheres are sorted along the longest axis of their centers and packed into leaves of 4 (in SoA layout), each leaf has
+	a bounding box that is tested first and its spheres are then tested in a single SSE batch (one lane at a time w/o SSE).
+	Rebuilding is O(n log n) in the number of targets, it is rebuilt once the targets are posed each frame (see App::onPose()). */
+class TargetBVH {
+public:
+	static const int LEAF_SIZE = 4;
+
+	/** A target whose bounding sphere is hit by a ray */
+	struct Candidate {
+		int		index;				///< Index into the targets array passed to rebuild()
+		float	distance;			///< Distance along the ray to the bounding sphere (0 if the ray starts inside it)
+
+		bool operator<(const Candidate& other) const { return distance < other.distance; }
+		bool operator>(const Candidate& other) const { return distance > other.distance; }
+	};
+
+protected:
+	struct Leaf {
+		float	cx[LEAF_SIZE], cy[LEAF_SIZE], cz[LEAF_SIZE];	///< Sphere centers
+		float	r2[LEAF_SIZE];									///< Squared sphere radii (inf for targets w/o bounds)
+		int		index[LEAF_SIZE];								///< Target indices (-1 for unused lanes)
+		AABox	bounds;											///< Bounds of all spheres in the leaf
+	};
+
+	Array<Leaf>		m_leaves;
+	Array<Sphere>	m_spheres;				///< Scratch for rebuild()
+	Array<int>		m_order;				///< Scratch for rebuild()
+
+public:
+	/** Rebuild from the targets' bounding spheres (see TargetEntity::hitBoundingSphere()). Targets that haven't been posed yet
+		have no bounds and are always returned as candidates. */
+	void rebuild(const Array<shared_ptr<TargetEntity>>& targets);
+
+	/** Get the targets whose bounding spheres the ray hits within maxDistance, sorted from nearest to farthest */
+	void intersectRay(const Ray& ray, float maxDistance, Array<Candidate>& candidates) const;
+
+	int leafCount() const { return m_leaves.size(); }
+};
@@ -1,11 +1,12 @@
 #include "TargetEntity.h"
+#include "SimClock.h"
 
 // Find an arbitrary vector perpendicular to and in equal length as inputV.
 // The sampling distribution is uniform along the circular line, the set of possible candidates of a perpendicular vector.,
-Point3 findPerpendicularVector(Point3 inputV) { // Note that the output vector has equal length as the input vector.
+Point3 findPerpendicularVector(Point3 inputV, Random& rng) { // Note that the output vector has equal length as the input vector.
 	Point3 perpen;
 	while (true) {
-		Point3 r = Point3::random();
+		Point3 r = Vector3::random(rng);
 		if (r.dot(inputV) > 0.1) { // avoid r being sharply aligned with the position vector
 			// calculate a perpendicular vector
 			perpen = r.cross(inputV.direction()) * inputV.length();
@@ -24,7 +25,113 @@ Point3 rotateToward(Point3 inputV, Point3 destinationV, float ang_deg) {
 	return (cos(ang_deg * pif() / 180.0f) * U + sin(ang_deg * pif() / 180.0f) * V) * inputV.length();
 }
 
-shared_ptr<TargetEntity> TargetEntity::create(	
+shared_ptr<DestinationSpline> DestinationSpline::create(const Array<Destination>& dests) {
+	alwaysAssertM(dests.size() > 1, "A destination spline requires at least 2 destinations!");
+	const shared_ptr<DestinationSpline>& spline = createShared<DestinationSpline>();
+	const int n = dests.size();
+
+	// Compute the velocity at each destination (finite difference of its neighbors w/ non-uniform time)
+	const bool closed = (dests[0].position - dests[n - 1].position).squaredLength() < 1e-8f;
+	Array<Vector3> velocity;
+	velocity.resize(n);
+	for (int i = 0; i < n; i++) {
+		Point3 prev, next;
+		SimTime dt;
+		if (i > 0 && i < n - 1) {
+			prev = dests[i - 1].position;
+			next = dests[i + 1].position;
+			dt = dests[i + 1].time - dests[i - 1].time;
+		}
+		else if (closed && n > 2) {
+			// Closed loop, use the neighbors across the start/end point
+			prev = dests[n - 2].position;
+			next = dests[1].position;
+			dt = (dests[1].time - dests[0].time) + (dests[n - 1].time - dests[n - 2].time);
+		}
+		else if (i == 0) {
+			prev = dests[0].position;
+			next = dests[1].position;
+			dt = dests[1].time - dests[0].time;
+		}
+		else {
+			prev = dests[n - 2].position;
+			next = dests[n - 1].position;
+			dt = dests[n - 1].time - dests[n - 2].time;
+		}
+		velocity[i] = (dt > 0) ? (next - prev) / (float)dt : Vector3::zero();
+	}
+
+	// Build the Hermite coefficients and arc-length table for each segment
+	spline->m_segments.resize(n - 1);
+	spline->m_length = 0.0f;
+	for (int i = 0; i < n - 1; i++) {
+		Segment& seg = spline->m_segments[i];
+		const Point3 p0 = dests[i].position;
+		const Point3 p1 = dests[i + 1].position;
+		const float h = max((float)(dests[i + 1].time - dests[i].time), 0.0f);
+		const Vector3 m0 = velocity[i] * h;				// Tangents scaled to the local parameter
+		const Vector3 m1 = velocity[i + 1] * h;
+
+		seg.a = 2.0f*(p0 - p1) + m0 + m1;
+		seg.b = 3.0f*(p1 - p0) - 2.0f*m0 - m1;
+		seg.c = m0;
+		seg.d = p0;
+
+		seg.arcLength[0] = 0.0f;
+		Point3 last = p0;
+		for (int j = 1; j <= ARC_SAMPLES; j++) {
+			const Point3 p = seg.evaluate((float)j / (float)ARC_SAMPLES);
+			seg.arcLength[j] = seg.arcLength[j - 1] + (p - last).length();
+			last = p;
+		}
+		spline->m_length += seg.arcLength[ARC_SAMPLES];
+	}
+	return spline;
+}
+
+Point3 DestinationSpline::evaluate(int segIdx, float u) const {
+	const Segment& seg = m_segments[clamp(segIdx, 0, m_segments.size() - 1)];
+	const float segLength = seg.arcLength[ARC_SAMPLES];
+	if (segLength <= 0.0f) return seg.d;					// Stationary segment
+
+	// Find the arc-length sample interval containing the target distance (fixed size table)
+	const float target = clamp(u, 0.0f, 1.0f) * segLength;
+	int lo = 0, hi = ARC_SAMPLES;
+	while (hi - lo > 1) {
+		const int mid = (lo + hi) / 2;
+		if (seg.arcLength[mid] <= target) lo = mid;
+		else hi = mid;
+	}
+	const float span = seg.arcLength[hi] - seg.arcLength[lo];
+	const float frac = (span > 0.0f) ? (target - seg.arcLength[lo]) / span : 0.0f;
+	return seg.evaluate(((float)lo + frac) / (float)ARC_SAMPLES);
+}
+
+void TargetTrajectory::bake(const shared_ptr<TargetEntity>& motion, SimTime duration) {
+	const SimTime dt = 1.0 / m_sampleRate;
+	const int count = iCeil(duration * m_sampleRate) + 1;
+	m_positions.resize(count);
+
+	// Start from a non-zero time (destination-based targets treat a spawn time of 0 as "not yet spawned")
+	const SimTime t0 = 1.0;
+	for (int i = 0; i < count; i++) {
+		motion->simulateMotion(t0 + i * dt, dt);
+		m_positions[i] = motion->frame().translation;
+	}
+	m_ready = true;
+}
+
+Point3 TargetTrajectory::position(SimTime t) const {
+	const double idx = max(t, 0.0) * m_sampleRate;
+	const int i = (int)idx;
+	if (i >= m_positions.size() - 1) {
+		return m_positions.last();
+	}
+	const float alpha = (float)(idx - i);
+	return m_positions[i] * (1.0f - alpha) + m_positions[i + 1] * alpha;
+}
+
+shared_ptr<TargetEntity> TargetEntity::create(
 	Array<Destination>				dests, 										
 	const String&					name,
 	Scene*							scene,
@@ -34,15 +141,66 @@ shared_ptr<TargetEntity> TargetEntity::create(
 	int								paramIdx,
 	Point3							offset,
 	int								respawns,
-	bool							isLogged)
+	bool							isLogged,
+	const shared_ptr<TargetEntity>&	pooled)
 {
-	const shared_ptr<TargetEntity>& target = createShared<TargetEntity>();
-	target->Entity::init(name, scene, CFrame(dests[0].position), shared_ptr<Entity::Track>(), true, true);
-	target->VisibleEntity::init(model, true, Surface::ExpressiveLightScatteringProperties(), ArticulatedModel::PoseSpline());
+	shared_ptr<TargetEntity> target = pooled;
+	if (isNull(target)) {
+		target = createShared<TargetEntity>();
+		target->Entity::init(name, scene, CFrame(dests[0].position), shared_ptr<Entity::Track>(), true, true);
+		target->VisibleEntity::init(model, true, Surface::ExpressiveLightScatteringProperties(), ArticulatedModel::PoseSpline());
+	}
+	else {
+		target->reuse(name, scene, model, CFrame(dests[0].position));
+	}
 	target->TargetEntity::init(dests, paramIdx, offset, respawns, scaleIdx, isLogged);
 	return target;
 }
 
+void TargetEntity::reuse(const String& name, Scene* scene, const shared_ptr<Model>& model, const CFrame& position) {
+	m_name = name;
+	m_scene = scene;
+	m_frame = position;
+	m_previousFrame = position;
+	m_posed = false;
+	m_snapPreviousFrame = true;
+	if (m_model != model) {
+		setModel(model);
+	}
+
+	// Reset the target state (the init() methods set the rest)
+	m_health = 1.0f;
+	m_spawnTime = 0;
+	m_worldSpace = false;
+	m_offset = Point3::zero();
+	m_spline = nullptr;
+	m_nextChangeTime = 0;
+	m_velocity = Vector3::zero();
+	m_trajectory = nullptr;
+	m_trajectoryStart = nan();
+	m_deferFrame = false;
+	m_motionUpdated = false;
+	m_externalMotion = false;
+	m_motionEpoch++;
+	m_rng->reset(Random::common().bits());		// Same draw from Random::common() as constructing a new target
+	resetMotionState();
+}
+
+void TargetPool::release(const shared_ptr<TargetEntity>& target) {
+	// Check the most derived types first
+	const shared_ptr<JumpingEntity>& jumping = dynamic_pointer_cast<JumpingEntity>(target);
+	if (notNull(jumping)) {
+		m_jumpingTargets.append(jumping);
+		return;
+	}
+	const shared_ptr<FlyingEntity>& flying = dynamic_pointer_cast<FlyingEntity>(target);
+	if (notNull(flying)) {
+		m_flyingTargets.append(flying);
+		return;
+	}
+	m_destTargets.append(target);
+}
+
 void TargetEntity::drawHealthBar(RenderDevice* rd, const Camera& camera, const Framebuffer& framebuffer, Point2 size, Point3 offset, Point2 border, Array<Color4> colors, Color4 borderColor) const
 {
 	// Abort if the target is not in front of the camera 
@@ -75,9 +233,96 @@ void TargetEntity::drawHealthBar(RenderDevice* rd, const Camera& camera, const F
 
 void TargetEntity::setDestinations(const Array<Destination> destinationArray) {
 	m_destinations = destinationArray;
+	m_spline = nullptr;				// Any spline was built from the old destinations
+}
+
+bool TargetEntity::playTrajectory(SimTime absoluteTime) {
+	if (isNull(m_trajectory)) return false;
+	if (isNaN(m_trajectoryStart)) {
+		if (!m_trajectory->ready()) {
+			// The bake hasn't completed, simulate live for the rest of the trial (rather than holding position, then jumping to the baked motion)
+			m_trajectory = nullptr;
+			return false;
+		}
+		m_trajectoryStart = absoluteTime;				// Playback time is relative to the first simulated frame
+		m_trajectory->played = true;
+		m_trajectory->playbackStart = SimClock::fileTime();
+	}
+	const SimTime t = absoluteTime - m_trajectoryStart;
+	m_trajectory->playedUntil = t;
+	setMotionFrame(m_trajectory->position(t));
+	return true;
+}
+
+void TargetEntity::updateMotion(SimTime absoluteTime, SimTime deltaTime) {
+	// Run the motion model against m_frame, then restore it so the scene is unchanged until the commit
+	const CFrame frame = m_frame;
+	const bool defer = m_deferFrame;
+	m_deferFrame = true;
+	if (!playTrajectory(absoluteTime)) {
+		simulateMotion(absoluteTime, deltaTime);
+	}
+	m_pendingFrame = m_frame;
+	m_frame = frame;
+	m_deferFrame = defer;
+	m_motionUpdated = true;
+}
+
+void TargetEntity::advanceMotion(SimTime absoluteTime, SimTime deltaTime) {
+	if (m_motionUpdated) {
+		m_motionUpdated = false;
+		setFrame(m_pendingFrame);
+	}
+	else if (m_externalMotion) {
+		// Hold position until the next externally simulated frame
+	}
+	else if (!playTrajectory(absoluteTime)) {
+		simulateMotion(absoluteTime, deltaTime);
+	}
+
+	if (m_snapPreviousFrame && !(isNaN(deltaTime) || (deltaTime == 0))) {
+		// First step since a (re)spawn or teleport, start interpolating from here rather than the old position
+		m_previousFrame = m_frame;
+		m_snapPreviousFrame = false;
+	}
+}
+
+void TargetEntity::onPose(Array<shared_ptr<Surface> >& surfaceArray) {
+	VisibleEntity::onPose(surfaceArray);
+	m_posedFrame = m_frame;
+	m_posed = true;
+}
+
+Sphere TargetEntity::hitBoundingSphere() const {
+	if (!m_posed) return Sphere(m_frame.translation, 0.0f);
+	Sphere bounds;
+	getLastBounds(bounds);
+	return bounds;
+}
+
+bool TargetEntity::intersectAsDisplayed(const Ray& ray, float& maxDistance) {
+	if (!m_posed) return intersect(ray, maxDistance);
+	const CFrame frame = m_frame;
+	m_frame = m_posedFrame;
+	const bool hit = intersect(ray, maxDistance);
+	m_frame = frame;
+	return hit;
 }
 
 void TargetEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
+	if (!(isNaN(deltaTime) || (deltaTime == 0))) {
+		m_previousFrame = m_frame;
+	}
+
+	advanceMotion(absoluteTime, deltaTime);
+
+#ifdef DRAW_BOUNDING_SPHERES
+	// Draw a 1m sphere at this position
+	debugDraw(Sphere(m_frame, BOUNDING_SPHERE_RADIUS), 0.0f, Color4::clear(), Color3::black());
+#endif
+}
+
+void TargetEntity::simulateMotion(SimTime absoluteTime, SimTime deltaTime) {
 	// Check whether we have any destinations yet...
 	if (m_destinations.size() < 2)
 		return;
@@ -98,23 +343,25 @@ void TargetEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
 	// Compute the position by interpolating
 	float duration = nextDest.time - currDest.time;			// Get the total time for this "step
 	duration = max(duration, 0.0f);							// In "wrap" case immediately teleport back to start (0 duration step)
-	
-	float prog = 1.0f;										// By default make the "full step"
-	if (duration > 0.0f) {
-		// Handle time "wrap" case here
-		if (nextDest.time < time) {
-			time -= getPathTime();							// Fix the "wrap" math for prog below
-		}
-		prog = (nextDest.time - time) / duration;			// Get the ratio of time in this step completed
+
+	if (notNull(m_spline) && destinationIdx < m_spline->segmentCount()) {
+		// Spline mode: evaluate the precomputed segment at the fraction of its time completed
+		const float u = (duration > 0.0f) ? (float)(time - currDest.time) / duration : 1.0f;
+		setMotionFrame(m_spline->evaluate(destinationIdx, u) + m_offset);
 	}
-	
-	Point3 delta = currDest.position - nextDest.position; 	// Get the delta vector to move along
-	setFrame((prog*delta) + currDest.position + m_offset);	// Set the new positions
+	else {
+		float prog = 1.0f;										// By default make the "full step"
+		if (duration > 0.0f) {
+			// Handle time "wrap" case here
+			if (nextDest.time < time) {
+				time -= getPathTime();							// Fix the "wrap" math for prog below
+			}
+			prog = (nextDest.time - time) / duration;			// Get the ratio of time in this step completed
+		}
 
-#ifdef DRAW_BOUNDING_SPHERES
-	// Draw a 1m sphere at this position
-	debugDraw(Sphere(m_frame, BOUNDING_SPHERE_RADIUS), 0.0f, Color4::clear(), Color3::black());
-#endif
+		Point3 delta = currDest.position - nextDest.position; 	// Get the delta vector to move along
+		setMotionFrame((prog*delta) + currDest.position + m_offset);	// Set the new positions
+	}
 }
 
 shared_ptr<Entity> FlyingEntity::create
@@ -170,14 +417,21 @@ shared_ptr<FlyingEntity> FlyingEntity::create
 	int										paramIdx,
 	Array<bool>								axisLock,
 	int										respawns,
-	bool									isLogged) {
+	bool									isLogged,
+	const shared_ptr<FlyingEntity>&			pooled) {
 
-	// Don't initialize in the constructor, where it is unsafe to throw Any parse exceptions
-	const shared_ptr<FlyingEntity>& flyingEntity = createShared<FlyingEntity>();
+	shared_ptr<FlyingEntity> flyingEntity = pooled;
+	if (isNull(flyingEntity)) {
+		// Don't initialize in the constructor, where it is unsafe to throw Any parse exceptions
+		flyingEntity = createShared<FlyingEntity>();
 
-	// Initialize each base class, which parses its own fields
-	flyingEntity->Entity::init(name, scene, position, shared_ptr<Entity::Track>(), true, true);
-	flyingEntity->VisibleEntity::init(model, true, Surface::ExpressiveLightScatteringProperties(), ArticulatedModel::PoseSpline());
+		// Initialize each base class, which parses its own fields
+		flyingEntity->Entity::init(name, scene, position, shared_ptr<Entity::Track>(), true, true);
+		flyingEntity->VisibleEntity::init(model, true, Surface::ExpressiveLightScatteringProperties(), ArticulatedModel::PoseSpline());
+	}
+	else {
+		flyingEntity->reuse(name, scene, model, position);
+	}
 	flyingEntity->FlyingEntity::init(speedRange, motionChangePeriodRange, upperHemisphereOnly, orbitCenter, paramIdx, axisLock, respawns, scaleIdx, isLogged);
 	return flyingEntity;
 }
@@ -248,17 +502,26 @@ void FlyingEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
 
 	simulatePose(absoluteTime, deltaTime);
 
+	advanceMotion(absoluteTime, deltaTime);
+
+#ifdef DRAW_BOUNDING_SPHERES
+	// Draw a 1m sphere at this position
+	debugDraw(Sphere(m_frame.translation, BOUNDING_SPHERE_RADIUS), 0.0f, Color4::clear(), Color3::black());
+#endif
+}
+
+void FlyingEntity::simulateMotion(SimTime absoluteTime, SimTime deltaTime) {
 	if (m_worldSpace) {
 		Point3 pos = m_frame.translation;
 		// Handle world-space target here
 		// Check for change in direction
 		if (absoluteTime > m_nextChangeTime) {
 			// Update the next change time
-			float motionChangeTime = Random::common().uniform(m_motionChangePeriodRange[0], m_motionChangePeriodRange[1]);
+			float motionChangeTime = m_rng->uniform(m_motionChangePeriodRange[0], m_motionChangePeriodRange[1]);
 			m_nextChangeTime = absoluteTime + motionChangeTime;
 			// Velocity to use for this next interval
-			float vel = Random::common().uniform(m_angularSpeedRange[0], m_angularSpeedRange[1]);
-			Point3 destination = m_bounds.randomInteriorPoint();
+			float vel = m_rng->uniform(m_angularSpeedRange[0], m_angularSpeedRange[1]);
+			Point3 destination = randomPoint(m_bounds);
 			if (m_axisLocks[0]) {
 				destination.x = pos.x;
 			}
@@ -298,15 +561,15 @@ void FlyingEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
 
 		// Update the position and set the frame
 		pos += m_velocity*deltaTime;		
-		setFrame(pos);
+		setMotionFrame(pos);
 	}
 	else {
 		// Handle non-world space (player projection here)
 		while ((deltaTime > 0.000001f) && m_angularSpeedRange[0] > 0.0f) {
 			if (m_destinationPoints.empty()) {
 				// Add destimation points if no destination points.
-				float motionChangePeriod = Random::common().uniform(m_motionChangePeriodRange[0], m_motionChangePeriodRange[1]);
-				float angularSpeed = Random::common().uniform(m_angularSpeedRange[0], m_angularSpeedRange[1]);
+				float motionChangePeriod = m_rng->uniform(m_motionChangePeriodRange[0], m_motionChangePeriodRange[1]);
+				float angularSpeed = m_rng->uniform(m_angularSpeedRange[0], m_angularSpeedRange[1]);
 				float angularDistance = motionChangePeriod * angularSpeed;
 				angularDistance = angularDistance > 170.f ? 170.0f : angularDistance; // replace with 170 deg if larger than 170.
 
@@ -317,7 +580,7 @@ void FlyingEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
 				// relative position to orbit center
 				Point3 relPos = m_frame.translation - m_orbitCenter;
 				// find a vector perpendicular to the current position
-				Point3 perpen = findPerpendicularVector(relPos);
+				Point3 perpen = findPerpendicularVector(relPos, *m_rng);
 				// calculate destination point
 				Point3 dest = m_orbitCenter + rotateToward(relPos, perpen, angularDistance);
 				// add destination point.
@@ -366,7 +629,7 @@ void FlyingEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
 				const Vector3& U = currentVector;
 				const Vector3& V = (destinationVector - currentVector * projection).direction();
 
-				setFrame(m_orbitCenter + (cos(angleChange) * U + sin(angleChange) * V) * radius);
+				setMotionFrame(m_orbitCenter + (cos(angleChange) * U + sin(angleChange) * V) * radius);
 			}
 
 			if (m_upperHemisphereOnly) {
@@ -383,10 +646,6 @@ void FlyingEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
 			}
 		}
 	}
-#ifdef DRAW_BOUNDING_SPHERES
-	// Draw a 1m sphere at this position
-	debugDraw(Sphere(m_frame.translation, BOUNDING_SPHERE_RADIUS), 0.0f, Color4::clear(), Color3::black());
-#endif
 }
 
 
@@ -429,14 +688,21 @@ shared_ptr<JumpingEntity> JumpingEntity::create
 	int										paramIdx,
 	Array<bool>								axisLock,
 	int										respawns, 
-	bool									isLogged) {
+	bool									isLogged,
+	const shared_ptr<JumpingEntity>&		pooled) {
 
-	// Don't initialize in the constructor, where it is unsafe to throw Any parse exceptions
-	const shared_ptr<JumpingEntity>& jumpingEntity = createShared<JumpingEntity>();
+	shared_ptr<JumpingEntity> jumpingEntity = pooled;
+	if (isNull(jumpingEntity)) {
+		// Don't initialize in the constructor, where it is unsafe to throw Any parse exceptions
+		jumpingEntity = createShared<JumpingEntity>();
 
-	// Initialize each base class, which parses its own fields
-	jumpingEntity->Entity::init(name, scene, position, shared_ptr<Entity::Track>(), true, true);
-	jumpingEntity->VisibleEntity::init(model, true, Surface::ExpressiveLightScatteringProperties(), ArticulatedModel::PoseSpline());
+		// Initialize each base class, which parses its own fields
+		jumpingEntity->Entity::init(name, scene, position, shared_ptr<Entity::Track>(), true, true);
+		jumpingEntity->VisibleEntity::init(model, true, Surface::ExpressiveLightScatteringProperties(), ArticulatedModel::PoseSpline());
+	}
+	else {
+		jumpingEntity->reuse(name, scene, model, position);
+	}
 	jumpingEntity->JumpingEntity::init(
 		angularSpeedRange,
 		motionChangePeriodRange,
@@ -496,9 +762,9 @@ void JumpingEntity::init(
 		m_axisLocks[i] = axisLock[i];
 	}
 	m_orbitRadius = orbitRadius;
-	float angularSpeed = Random::common().uniform(m_angularSpeedRange[0], m_angularSpeedRange[1]);
+	float angularSpeed = m_rng->uniform(m_angularSpeedRange[0], m_angularSpeedRange[1]);
 	m_planarSpeedGoal = m_orbitRadius * (angularSpeed * pif() / 180.0f);
-	if (Random::common().uniform() > 0.5f) {
+	if (m_rng->uniform() > 0.5f) {
 		m_planarSpeedGoal = -m_planarSpeedGoal;
 	}
 	// [m/s] = [m/radians] * [radians/s]
@@ -506,8 +772,8 @@ void JumpingEntity::init(
 	m_speed.y = 0.0f;
 
 	m_inJump = false;
-	m_motionChangeTimer = Random::common().uniform(m_motionChangePeriodRange[0], m_motionChangePeriodRange[1]);
-	m_jumpTimer = Random::common().uniform(m_jumpPeriodRange[0], m_jumpPeriodRange[1]);
+	m_motionChangeTimer = m_rng->uniform(m_motionChangePeriodRange[0], m_motionChangePeriodRange[1]);
+	m_jumpTimer = m_rng->uniform(m_jumpPeriodRange[0], m_jumpPeriodRange[1]);
 }
 
 Any JumpingEntity::toAny(const bool forceAll) const {
@@ -516,202 +782,258 @@ Any JumpingEntity::toAny(const bool forceAll) const {
 	return a;
 }
 
-void JumpingEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
-	// Do not call Entity::onSimulation; that will override with spline animation
+float JumpSegment::planarDistance(float t) const {
+	if (t < saturationTime) {
+		return (planarSpeed + 0.5f * planarAcc * t) * t;
+	}
+	// Accelerate up to the speed goal, then hold it
+	const float ts = saturationTime;
+	return (planarSpeed + 0.5f * planarAcc * ts) * ts + planarSpeedGoal * (t - ts);
+}
 
-	if (!(isNaN(deltaTime) || (deltaTime == 0))) {
-		m_previousFrame = m_frame;
+Point3 JumpSegment::simulatedPosition(float t) const {
+	const float angle = (planarRadius > 0.0f) ? angle0 + planarDistance(t) / planarRadius : angle0;
+	return Point3(orbitCenter.x + cos(angle) * planarRadius, height(t), orbitCenter.z + sin(angle) * planarRadius);
+}
+
+Point3 JumpSegment::position(float t) const {
+	if (worldSpace) {
+		return origin + velocity * t + Vector3(0.0f, height(t), 0.0f);
 	}
+	// Project the simulated position onto the orbit sphere
+	const Vector3 relativePos = simulatedPosition(t) - orbitCenter;
+	return orbitCenter + relativePos.direction() * orbitRadius;
+}
 
-	simulatePose(absoluteTime, deltaTime);
+/** Time for a jump at height h0 (moving at v w/ acceleration a) to come back down to ground, returns inf if it never does */
+static float timeToLand(float h0, float v, float a, float ground) {
+	if (a >= 0.0f) return finf();
+	// Solve 0 = a/2 * t^2 + v * t + (h0 - ground) for the positive solution (a is negative)
+	const float disc = v * v - 2.0f * a * (h0 - ground);
+	if (disc < 0.0f) return 0.0f;
+	return max((-v - sqrtf(disc)) / a, 0.0f);
+}
+
+void JumpingEntity::resetMotion() {
+	m_isFirstFrame = false;
+	m_motionStartEpoch = m_motionEpoch;
+	m_localTime = 0;
+	m_simulatedPos = m_frame.translation;
+	m_standingHeight = m_frame.translation.y;
+	m_acc.y = -m_rng->uniform(m_gravityRange[0], m_gravityRange[1]);
+	m_jumpSpeed = m_rng->uniform(m_jumpSpeedRange[0], m_jumpSpeedRange[1]);
+
+	// Start out of a jump
+	m_inJump = false;
+	m_jumpHeight = 0.0f;
+	m_speed.x = m_planarSpeedGoal;
+	m_speed.y = 0.0f;
+	m_nextChangeTime = 0;
+	m_nextJumpTime = 0;
+
+	beginSegment(0);
+}
 
-	if (m_isFirstFrame) {
-		m_simulatedPos = m_frame.translation;
-		m_standingHeight = m_frame.translation.y;
-		m_isFirstFrame = false;
-		m_acc.y = -Random::common().uniform(m_gravityRange[0], m_gravityRange[1]);
-		m_jumpSpeed = Random::common().uniform(m_jumpSpeedRange[0], m_jumpSpeedRange[1]);
+void JumpingEntity::beginSegment(SimTime startTime) {
+	JumpSegment seg;
+	seg.startTime = startTime;
+	seg.inJump = m_inJump;
+	seg.gravity = m_acc.y;
+	seg.jumpSpeed = m_speed.y;
+	if (m_worldSpace) {
+		beginWorldSegment(seg);
+	}
+	else {
+		beginPlayerSegment(seg);
 	}
+	m_segment = seg;
+	if (m_isLogged) {
+		m_segmentLog.append(seg);
+	}
+}
+
+void JumpingEntity::beginWorldSegment(JumpSegment& seg) {
+	seg.worldSpace = true;
+	seg.origin = m_simulatedPos;
+	seg.velocity = m_velocity;
+	seg.height0 = m_jumpHeight;
+
+	// Time until each possible state change
+	const float motionChange = max((float)(m_nextChangeTime - seg.startTime), 0.0f);
+	m_jumpChangeTime = m_inJump ? timeToLand(m_jumpHeight, m_speed.y, m_acc.y, 0.0f) : max((float)(m_nextJumpTime - seg.startTime), 0.0f);
+
+	// Time at which the base position leaves the bounds (ignore axes already outside)
+	float bounce = finf();
+	for (int i = 0; i < 3; i++) {
+		const float v = m_velocity[i];
+		if (v == 0.0f) continue;
+		const float boundary = (v > 0.0f) ? m_bounds.high()[i] : m_bounds.low()[i];
+		const float t = (boundary - m_simulatedPos[i]) / v;
+		if (t >= 0.0f) bounce = min(bounce, t);
+	}
+
+	seg.duration = min(motionChange, m_jumpChangeTime, bounce);
+	if (seg.duration == motionChange)		seg.endEvents |= JumpSegment::MotionChange;
+	if (seg.duration == m_jumpChangeTime)	seg.endEvents |= m_inJump ? JumpSegment::JumpEnd : JumpSegment::JumpStart;
+	if (seg.duration == bounce)				seg.endEvents |= JumpSegment::Bounce;
+}
+
+void JumpingEntity::beginPlayerSegment(JumpSegment& seg) {
+	seg.worldSpace = false;
+	seg.orbitCenter = m_orbitCenter;
+	seg.orbitRadius = m_orbitRadius;
+	seg.height0 = m_simulatedPos.y;
+
+	// Planar component (purely rotation about the vertical axis through the orbit center)
+	const Vector3 planar = Vector3(m_simulatedPos.x - m_orbitCenter.x, 0.0f, m_simulatedPos.z - m_orbitCenter.z);
+	seg.planarRadius = planar.length();
+	seg.angle0 = atan2(planar.z, planar.x);
+	seg.planarSpeed = m_speed.x;
+	seg.planarSpeedGoal = m_planarSpeedGoal;
+	if (m_inJump) {
+		// Planar speed changes during the jump until it passes the goal speed (then it is held there)
+		seg.planarAcc = m_acc.x;
+		const float goal = m_planarSpeedGoal;
+		if ((goal > 0.0f && m_speed.x > goal) || (goal < 0.0f && m_speed.x < goal)) {
+			seg.saturationTime = 0.0f;
+		}
+		else if ((goal > 0.0f && m_acc.x > 0.0f) || (goal < 0.0f && m_acc.x < 0.0f)) {
+			seg.saturationTime = (goal - m_speed.x) / m_acc.x;
+		}
+	}
+
+	// Time until the next motion change and jump state change
+	m_jumpChangeTime = m_inJump ? timeToLand(m_simulatedPos.y, m_speed.y, m_acc.y, m_standingHeight) : max(m_jumpTimer, 0.0f);
+	const float motionChange = max(m_motionChangeTimer, 0.0f);
+
+	seg.duration = min(motionChange, m_jumpChangeTime);
+	if (seg.duration == motionChange)		seg.endEvents |= JumpSegment::MotionChange;
+	if (seg.duration == m_jumpChangeTime)	seg.endEvents |= m_inJump ? JumpSegment::JumpEnd : JumpSegment::JumpStart;
+}
+
+void JumpingEntity::nextSegment() {
+	const JumpSegment& seg = m_segment;
+	const float t = seg.duration;
+	const SimTime endTime = seg.endTime();
 
 	if (m_worldSpace) {
-		// Implement world-space target logic here
-		Point3 pos = m_frame.translation;			// Get the starting position
-		// Check for time for motion (direction) change
-		if (absoluteTime > m_nextChangeTime) {
+		// Move the state to the end of the segment
+		m_simulatedPos = seg.origin + seg.velocity * t;
+		m_jumpHeight = seg.height(t);
+		m_speed.y = seg.verticalSpeed(t);
+
+		if (seg.endEvents & JumpSegment::Bounce) {
+			m_velocity = -m_velocity;
+		}
+		if (seg.endEvents & JumpSegment::MotionChange) {
 			// Update the next change time
-			float motionChangeTime = Random::common().uniform(m_motionChangePeriodRange[0], m_motionChangePeriodRange[1]);
-			m_nextChangeTime = absoluteTime + motionChangeTime;
+			const float motionChangeTime = m_rng->uniform(m_motionChangePeriodRange[0], m_motionChangePeriodRange[1]);
+			m_nextChangeTime = endTime + motionChangeTime;
 			// Velocity to use for this next interval
-			float vel = Random::common().uniform(m_angularSpeedRange[0], m_angularSpeedRange[1]);
-			Point3 destination = m_bounds.randomInteriorPoint();
-			if (m_axisLocks[0]) {
-				destination.x = frame().translation.x;
-			}
-			if (m_axisLocks[1]) {
-				destination.y = frame().translation.y;
-			}
-			if (m_axisLocks[2]) {
-				destination.z = frame().translation.z;
+			const float vel = m_rng->uniform(m_angularSpeedRange[0], m_angularSpeedRange[1]);
+			Point3 destination = randomPoint(m_bounds);
+			for (int i = 0; i < 3; i++) {
+				if (m_axisLocks[i]) destination[i] = m_simulatedPos[i];
 			}
 			if (m_axisLocks[0] && m_axisLocks[1] && m_axisLocks[2] && vel > 0) {
 				throw "Cannot lock all axes for non-static target!";
 			}
-			m_velocity = vel * (destination - m_frame.translation).direction();
-		}
-		// Check for time for jump
-		if (absoluteTime > m_nextJumpTime && !m_inJump) {
-			m_standingHeight = pos.y;
-			m_inJump = true;				// Note we are in the jump
-			m_jumpTime = absoluteTime;
+			m_velocity = vel * (destination - m_simulatedPos).direction();
 		}
-		
-		// Add the velocity
-		pos += m_velocity * deltaTime;
-
-		// Check for whether the target has "left" the bounds
-		float height = pos.y;
-		if (m_inJump) {
-			pos.y = m_standingHeight;
+		if (seg.endEvents & JumpSegment::JumpEnd) {
+			m_inJump = false;
+			m_jumpHeight = 0.0f;				// Reset to the original height
+			m_speed.y = 0.0f;
+			// Schedule the next jump here
+			const float nextJump = m_rng->uniform(m_jumpPeriodRange[0], m_jumpPeriodRange[1]);
+			m_nextJumpTime = endTime + nextJump;
 		}
-		if (!m_bounds.contains(pos)) {
-			m_velocity = Vector3(-m_velocity.x, -m_velocity.y, -m_velocity.z);
+		else if (seg.endEvents & JumpSegment::JumpStart) {
+			m_inJump = true;					// Note we are in the jump
+			m_jumpHeight = 0.0f;
+			m_speed.y = m_jumpSpeed;
 		}
+	}
+	else {
+		// Move the state to the end of the segment
+		m_simulatedPos = seg.simulatedPosition(t);
 		if (m_inJump) {
-			pos.y = height;
+			m_speed.x = seg.planarSpeedAt(t);
+			m_speed.y = seg.verticalSpeed(t);
 		}
-
-		// Check for jump condition
-		if (m_inJump) {
-			SimTime dt = absoluteTime - m_jumpTime;
-			float jumpTime = -m_jumpSpeed / m_acc.y
-				- sqrtf(m_jumpSpeed*m_jumpSpeed - m_acc.y * pos.y + m_acc.y * m_standingHeight) / m_acc.y;
-			// Check if jump is over (time-based)
-			if (dt > jumpTime) {
-				m_inJump = false;
-				m_jumpTime = 0;
-				pos.y = m_standingHeight;		// Reset to the original height
-				// Schedule the next jump here
-				float nextJump = Random::common().uniform(m_jumpPeriodRange[0], m_jumpPeriodRange[1]);
-				m_nextJumpTime = absoluteTime + nextJump;
+		m_jumpTimer -= t;
+		m_motionChangeTimer -= t;
+
+		if (seg.endEvents & JumpSegment::MotionChange) { // changing motion direction
+			float new_AngularSpeedGoal = m_rng->uniform(m_angularSpeedRange[0], m_angularSpeedRange[1]);
+			float new_planarSpeedGoal = m_orbitRadius * (new_AngularSpeedGoal * pif() / 180.0f);
+			// change direction
+			if (m_planarSpeedGoal > 0) {
+				new_planarSpeedGoal = -new_planarSpeedGoal;
 			}
-			else {
-				// Attempt jump simulation here
-				pos.y += 0.5f * m_acc.y * dt * dt + m_jumpSpeed * dt;
+			// assign as the new speed goal
+			m_planarSpeedGoal = new_planarSpeedGoal;
+			if (m_inJump) { // if in jump, flip planar acceleration direction
+				m_acc.x = sign(m_planarSpeedGoal) * m_planarAcc;
+			}
+			else { // if not in jump, immediately apply direction change
+				m_speed.x = m_planarSpeedGoal;
 			}
+			m_motionChangeTimer = m_rng->uniform(m_motionChangePeriodRange[0], m_motionChangePeriodRange[1]);
+		}
+		if (seg.endEvents & JumpSegment::JumpEnd) { // finishing jump
+			m_simulatedPos.y = m_standingHeight; // hard-set to non-jumping height.
+			m_acc.y = 0; // remove gravity effect
+			m_speed.x = m_planarSpeedGoal; // instantly gain the running speed. (general behavior in games)
+			m_speed.y = 0;
+			m_inJump = false;
+			m_jumpTimer = m_rng->uniform(m_jumpPeriodRange[0], m_jumpPeriodRange[1]);
+		}
+		else if (seg.endEvents & JumpSegment::JumpStart) { // starting jump
+			m_acc.x = sign(m_planarSpeedGoal) * m_planarAcc;
+			float gravity = -m_rng->uniform(m_gravityRange[0], m_gravityRange[1]);
+			float jumpSpeed = m_rng->uniform(m_jumpSpeedRange[0], m_jumpSpeedRange[1]);
+			float distance = m_rng->uniform(m_distanceRange[0], m_distanceRange[1]);
+			m_acc.y = gravity * m_orbitRadius / distance;
+			m_speed.y = jumpSpeed * m_orbitRadius / distance;
+			m_planarAcc = m_acc.y / 3.f;
+			m_inJump = true;
 		}
-
-		// Update the position
-		setFrame(pos);
 	}
-	else {
-		while (deltaTime > 0.000001f) {
-			/// Decide time step size for motion simulation.
-			// Calculate remaining time until next state change for motion and jump
-			float nextJumpStateChange;
-			if (m_inJump) {
-				// Find when the current jump ends from now. We need to solve a kinematic equation here.
-				// 0 = a * t ^ 2 + 2 * v * t + (y - y0)
-				// a: acceleration, t: time, v: velocity, y: height, y0: standing height (before jump started)
-				// The equation comes with one positive and one negative solution. Ignore negative (it's "when did the jump start?")
-				// The following is the positive solution. Note that a is negative (- g).
-				// t = - v / a - sqrt(v ^ 2 - ah + ah0) / a
-				nextJumpStateChange =
-					-m_speed.y / m_acc.y
-					- sqrtf(m_speed.y * m_speed.y - m_acc.y * m_simulatedPos.y + m_acc.y * m_standingHeight) / m_acc.y;
-				int aa = 1;
-			}
-			else {
-				nextJumpStateChange = m_jumpTimer;
-			}
-			// Decide time step size t where motion state is consistent.
-			float t = G3D::min(deltaTime, m_motionChangeTimer, nextJumpStateChange);
-
-			/// Update position, planar component
-			Point3 planar_center = Point3(m_orbitCenter.x, m_standingHeight, m_orbitCenter.z);
-			Point3 planar_pos = Point3(m_simulatedPos.x, m_standingHeight, m_simulatedPos.z); // purely rotation component of the position vector
-			float radius = (planar_pos - planar_center).length();
-			float d;
-			if (m_inJump) {
-				d = m_speed.x * t + m_acc.x * t * t / 2; // metric distance to travel.
-			}
-			else {
-				d = m_speed.x * t;
-			}
-			float angularDistance = d / radius; // unit is radian
-			// Calculate the position.
-			Point3 U = (planar_pos - planar_center).direction();
-			// Find a perpendicular vector toward the direction of rotation.
-			Point3 V;
-			V = U.cross(Point3(0.f, 1.f, 0.f));
-			Point3 o = m_orbitCenter + (cos(angularDistance) * U + sin(angularDistance) * V) * radius;
-			m_simulatedPos.x = o.x;
-			m_simulatedPos.z = o.z;
-
-			/// Update position, jump component
-			if (m_inJump) {
-				m_simulatedPos.y = 0.5f * m_acc.y * t * t + m_speed.y * t + m_simulatedPos.y;
-			}
-
-			/// Update animated position.
-			// Project to the spherical surface, and update the frame translation vector.
-			Point3 relativePos = m_simulatedPos - m_orbitCenter;
-			m_frame.translation = relativePos.direction() * m_orbitRadius + m_orbitCenter;
 
-			/// Update velocity
-			if (m_inJump) {
-				m_speed = m_speed + m_acc * t;
-				if ((m_planarSpeedGoal > 0 && m_speed.x > m_planarSpeedGoal) || (m_planarSpeedGoal < 0 && m_speed.x < m_planarSpeedGoal)) {
-					m_speed.x = m_planarSpeedGoal;
-				}
-			}
+	beginSegment(endTime);
+}
 
-			/// Update motion state (includes updating acceleration)
-			if (t == m_motionChangeTimer) { // changing motion direction
-				float new_AngularSpeedGoal = Random::common().uniform(m_angularSpeedRange[0], m_angularSpeedRange[1]);
-				float new_planarSpeedGoal = m_orbitRadius * (new_AngularSpeedGoal * pif() / 180.0f);
-				// change direction
-				if (m_planarSpeedGoal > 0) {
-					new_planarSpeedGoal = -new_planarSpeedGoal;
-				}
-				// assign as the new speed goal
-				m_planarSpeedGoal = new_planarSpeedGoal;
-				if (m_inJump) { // if in jump, flip planar acceleration direction
-					m_acc.x = sign(m_planarSpeedGoal) * m_planarAcc;
-				}
-				else { // if not in jump, immediately apply direction change
-					m_speed.x = m_planarSpeedGoal;
-				}
-				m_motionChangeTimer = Random::common().uniform(m_motionChangePeriodRange[0], m_motionChangePeriodRange[1]);
-			}
-			if (t == nextJumpStateChange) { // either starting or finishing jump
-				if (m_inJump) { // finishing jump
-					m_simulatedPos.y = m_standingHeight; // hard-set to non-jumping height.
-					m_acc.y = 0; // remove gravity effect
-					m_speed.x = m_planarSpeedGoal; // instantly gain the running speed. (general behavior in games)
-					m_inJump = false;
-					m_jumpTimer = Random::common().uniform(m_jumpPeriodRange[0], m_jumpPeriodRange[1]);
-				}
-				else { // starting jump
-					m_acc.x = sign(m_planarSpeedGoal) * m_planarAcc;
-					float gravity = -Random::common().uniform(m_gravityRange[0], m_gravityRange[1]);
-					float jumpSpeed = Random::common().uniform(m_jumpSpeedRange[0], m_jumpSpeedRange[1]);
-					float distance = Random::common().uniform(m_distanceRange[0], m_distanceRange[1]);
-					m_acc.y = gravity * m_orbitRadius / distance;
-					m_speed.y = jumpSpeed * m_orbitRadius / distance;
-					m_planarAcc = m_acc.y / 3.f;
-					m_inJump = true;
-				}
-			}
+void JumpingEntity::onSimulation(SimTime absoluteTime, SimTime deltaTime) {
+	// Do not call Entity::onSimulation; that will override with spline animation
 
-			/// decrement deltaTime and timers by t
-			deltaTime -= t;
-			m_jumpTimer -= t;
-			m_motionChangeTimer -= t;
-		}
+	if (!(isNaN(deltaTime) || (deltaTime == 0))) {
+		m_previousFrame = m_frame;
 	}
+
+	simulatePose(absoluteTime, deltaTime);
+
+	advanceMotion(absoluteTime, deltaTime);
+
 #ifdef DRAW_BOUNDING_SPHERES
 	// Draw a 1m sphere at this position
 	debugDraw(Sphere(m_frame.translation, BOUNDING_SPHERE_RADIUS), 0.0f, Color4::clear(), Color3::black());
 #endif
 }
 
+void JumpingEntity::simulateMotion(SimTime absoluteTime, SimTime deltaTime) {
+	// (Re)start the motion on the first frame, or if the target was moved (respawned, teleported) since the last frame
+	if (m_isFirstFrame || m_motionEpoch != m_motionStartEpoch) {
+		resetMotion();
+	}
+	else if (!isNaN(deltaTime)) {
+		m_localTime += deltaTime;
+	}
+
+	// Only do work (and random draws) at state changes, otherwise just evaluate the current segment
+	// (the step limit guards against configurations w/ zero-length motion change/jump periods)
+	for (int steps = 0; m_localTime >= m_segment.endTime() && steps < MAX_SEGMENTS_PER_FRAME; steps++) {
+		nextSegment();
+	}
+	setMotionFrame(m_segment.position((float)(m_localTime - m_segment.startTime)));
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <G3D/G3D.h>
+#include <atomic>
 
 //#define DRAW_BOUNDING_SPHERES	1		// Uncomment this to draw bounding spheres (useful for target sizing)
 #define BOUNDING_SPHERE_RADIUS	0.5		///< Use a 0.5m radius for sizing here
@@ -47,6 +48,74 @@ public:
 	}
 };
 
+/** Catmull-Rom (cubic Hermite) spline through an array of destinations.
+	Segment coefficients and per-segment arc-length tables are computed once when the spline is
+	created, so evaluating a position is a fixed amount of work regardless of path length. */
+class DestinationSpline : public ReferenceCountedObject {
+public:
+	static const int ARC_SAMPLES = 16;					///< Number of arc-length samples stored per segment
+
+protected:
+	/** Cubic polynomial p(s) = ((a*s + b)*s + c)*s + d over local parameter s in [0,1] */
+	struct Segment {
+		Vector3 a, b, c;
+		Point3	d;
+		float	arcLength[ARC_SAMPLES + 1];				///< Cumulative arc length at s = i/ARC_SAMPLES
+
+		Point3 evaluate(float s) const { return ((a*s + b)*s + c)*s + d; }
+	};
+
+	Array<Segment>	m_segments;							///< One segment per pair of consecutive destinations
+	float			m_length = 0.0f;					///< Total arc length of the path
+
+	DestinationSpline() {}
+
+public:
+	/** Build the spline (and its arc-length tables) from a destination array (requires at least 2 destinations) */
+	static shared_ptr<DestinationSpline> create(const Array<Destination>& dests);
+
+	/** Position along segment segIdx, where u in [0,1] is the fraction of the segment's time completed.
+		Progress is reparameterized by arc length so speed within a segment is constant, as in linear mode. */
+	Point3 evaluate(int segIdx, float u) const;
+
+	int segmentCount() const { return m_segments.size(); }
+	float length() const { return m_length; }
+};
+
+class TargetEntity;
+
+/** Target positions sampled at a fixed rate over an entire trial. Trajectories are baked ahead of time
+	(on a worker thread) from a copy of the target's motion model, then played back by table lookup. */
+class TargetTrajectory : public ReferenceCountedObject {
+protected:
+	float				m_sampleRate;					///< Samples per second
+	Array<Point3>		m_positions;					///< Position samples (written only by bake())
+	std::atomic<bool>	m_ready;						///< Set once bake() has completed
+
+	TargetTrajectory(float sampleRate) : m_sampleRate(sampleRate), m_ready(false) {}
+
+public:
+	SimTime				playedUntil = 0;				///< Latest trajectory time played back (written during target updates)
+	bool				played = false;					///< Has playback started?
+	FILETIME			playbackStart = {};				///< Time playback started (the trajectory is logged relative to this)
+
+	static shared_ptr<TargetTrajectory> create(float sampleRate) {
+		return createShared<TargetTrajectory>(sampleRate);
+	}
+
+	/** Simulate motion (a private copy of a target, see TargetEntity::copyMotion()) for duration seconds and store the samples.
+		Safe to call from a worker thread, the trajectory is only played back if this has completed when playback would start. */
+	void bake(const shared_ptr<TargetEntity>& motion, SimTime duration);
+
+	bool ready() const { return m_ready; }
+	float sampleRate() const { return m_sampleRate; }
+	int size() const { return m_positions.size(); }
+	const Point3& sample(int i) const { return m_positions[i]; }
+
+	/** Position at time t (linearly interpolated between samples, held at the last sample) */
+	Point3 position(SimTime t) const;
+};
+
 class TargetEntity : public VisibleEntity {
 protected:
 	float	m_health			= 1.0f;				///< Target health
@@ -60,13 +129,53 @@ protected:
 	bool	m_isLogged			= true;				///< Control flag for logging
 	Point3	m_offset;								///< Offset for initial spawn
 	Array<Destination> m_destinations;				///< Array of destinations to visit
+	shared_ptr<DestinationSpline> m_spline;			///< Precomputed spline through m_destinations (null for linear interpolation)
 
 	// Only used for flying/jumping entities
 	SimTime m_nextChangeTime = 0;
 	Vector3 m_velocity = Vector3::zero();
 
+	shared_ptr<TargetTrajectory> m_trajectory;		///< Baked trajectory to play back (null for live simulation)
+	SimTime m_trajectoryStart = nan();				///< Time at which trajectory playback started
+
+	shared_ptr<Random> m_rng;						///< Per-target random source (so motion doesn't depend on update order or thread)
+	bool	m_deferFrame		= false;			///< Write motion directly to m_frame instead of calling setFrame()
+	bool	m_motionUpdated		= false;			///< Has updateMotion() produced m_pendingFrame for the next onSimulation()?
+	CFrame	m_pendingFrame;							///< Frame computed by updateMotion(), committed in onSimulation()
+	bool	m_externalMotion	= false;			///< Motion is simulated elsewhere (see SimulationThread), only frames from setMotionResult() are committed
+	uint32	m_motionEpoch		= 0;				///< Incremented when motion restarts (respawn/reuse/teleport), so motion models and external copies know to restart
+	CFrame	m_posedFrame;							///< Frame of the last pose, i.e. as displayed (the last bounds were computed at this frame)
+	bool	m_posed				= false;			///< Has the target been posed (since it was spawned)?
+	bool	m_snapPreviousFrame	= true;				///< Don't interpolate from the previous frame after the next step (spawn, respawn, teleport)
+
+	/** Set the frame from the baked trajectory (if there is one), returns false if motion should be simulated live */
+	bool playTrajectory(SimTime absoluteTime);
+
+	/** Set the frame from motion code (deferred to the commit in onSimulation() when updating from a job) */
+	void setMotionFrame(const CFrame& frame) {
+		if (m_deferFrame) m_frame = frame;
+		else setFrame(frame);
+	}
+
+	/** Random point inside bounds (drawn from m_rng) */
+	Point3 randomPoint(const AABox& bounds) {
+		const Point3& lo = bounds.low();
+		const Point3& hi = bounds.high();
+		return Point3(m_rng->uniform(lo.x, hi.x), m_rng->uniform(lo.y, hi.y), m_rng->uniform(lo.z, hi.z));
+	}
+
+	/** Commit motion computed by updateMotion() if there is any, otherwise play back/simulate motion here */
+	void advanceMotion(SimTime absoluteTime, SimTime deltaTime);
+
+	/** Prepare a pooled (previously removed) target for reuse in place of Entity/VisibleEntity::init(), see TargetPool */
+	void reuse(const String& name, Scene* scene, const shared_ptr<Model>& model, const CFrame& position);
+
+	/** Reset subclass motion state to that of a newly constructed target (called by reuse()) */
+	virtual void resetMotionState() {}
+
 public:
-	TargetEntity() {}
+	/** Seeds the per-target random source from Random::common(), so construct targets from the main thread */
+	TargetEntity() : m_rng(std::make_shared<Random>(Random::common().bits(), false)) {}
 
 	static shared_ptr<TargetEntity> create(
 		Array<Destination>				dests,
@@ -78,7 +187,8 @@ public:
 		int								paramIdx,
 		Point3							offset=Point3::zero(),
 		int								respawns=0,
-		bool							isLogged=true);
+		bool							isLogged=true,
+		const shared_ptr<TargetEntity>&	pooled=nullptr);
 
 	void init(Array<Destination> dests, int paramIdx, Point3 staticOffset = Point3(0.0, 0.0, 0.0), int respawnCount=0, int scaleIdx=0, bool isLogged=true) {
 		setDestinations(dests);
@@ -92,6 +202,9 @@ public:
 
 	void setWorldSpace(bool worldSpace) { m_worldSpace = worldSpace; }
 
+	/** Use a precomputed spline (built from the same destinations) in place of linear interpolation */
+	void setSpline(const shared_ptr<DestinationSpline>& spline) { m_spline = spline; }
+
 	/**Simple routine to do damage */
 	bool doDamage(float damage) {
 		m_health -= damage;
@@ -107,6 +220,9 @@ public:
 		// Reset target parameters
 		m_spawnTime = 0;
 		m_health = 1.0f;
+		m_trajectory = nullptr;			// Baked motion doesn't include the respawn, simulate live from here
+		m_motionEpoch++;
+		m_snapPreviousFrame = true;
 		return true;					// Also returns true for any target w/ negative m_respawnCount
 	}
 
@@ -130,8 +246,77 @@ public:
 	int respawnsRemaining() { return m_respawnCount; }
 	int paramIdx() { return m_paramIdx; }
 
+	/** Play back a baked trajectory in place of simulating motion (until the target respawns) */
+	void setTrajectory(const shared_ptr<TargetTrajectory>& trajectory) {
+		m_trajectory = trajectory;
+		m_trajectoryStart = nan();
+	}
+	shared_ptr<TargetTrajectory> trajectory() const { return m_trajectory; }
+
+	/** Copy of this target's motion state (not inserted into the scene, not logged) for baking trajectories.
+		The copy gets its own random source (seeded from this target's) and never calls setFrame().
+		It doesn't keep the target's model, poses or scene, only the motion parameters and state. */
+	virtual shared_ptr<TargetEntity> copyMotion() {
+		const shared_ptr<TargetEntity>& copy = createShared<TargetEntity>(*this);
+		initMotionCopy(copy);
+		return copy;
+	}
+
+	/** Compute this target's motion for the upcoming onSimulation(absoluteTime, deltaTime) without modifying the scene.
+		Safe to call for different targets from multiple threads, the result is committed (single-threaded) by onSimulation(). */
+	void updateMotion(SimTime absoluteTime, SimTime deltaTime);
+
+	/** Drive this target's motion from outside (i.e. the simulation thread), onSimulation() then only commits frames from setMotionResult() */
+	void setExternalMotion(bool external) { m_externalMotion = external; }
+	bool externalMotion() const { return m_externalMotion; }
+
+	/** Frame to commit in the next onSimulation() (for externally simulated motion) */
+	void setMotionResult(const CFrame& frame) {
+		m_pendingFrame = frame;
+		m_motionUpdated = true;
+	}
+
+	/** Changes whenever the target's motion restarts (respawn, reuse, teleport) */
+	uint32 motionEpoch() const { return m_motionEpoch; }
+
+protected:
+	void initMotionCopy(const shared_ptr<TargetEntity>& copy) {
+		// Drop the render/scene state, the copy only runs the motion model
+		copy->m_model = nullptr;
+		copy->m_pose = nullptr;
+		copy->m_previousPose = nullptr;
+		copy->m_scene = nullptr;
+		copy->m_isLogged = false;
+		copy->m_trajectory = nullptr;
+		copy->m_deferFrame = true;
+		copy->m_motionUpdated = false;
+		copy->m_externalMotion = false;
+		copy->m_rng = std::make_shared<Random>(m_rng->bits(), false);
+	}
+
+public:
 	void drawHealthBar(RenderDevice* rd, const Camera& camera, const Framebuffer& framebuffer, Point2 size, Point3 offset, Point2 border, Array<Color4> colors, Color4 borderColor) const;
 	virtual void onSimulation(SimTime absoluteTime, SimTime deltaTime) override;
+	virtual void onPose(Array<shared_ptr<Surface> >& surfaceArray) override;
+
+	/** Bounding sphere of the target as it was last displayed (see intersectAsDisplayed()).
+		Has a radius of 0 if the target has not been posed yet. */
+	Sphere hitBoundingSphere() const;
+
+	/** Intersect the target at the (interpolated) frame it was last posed at, so hits match what the player saw.
+		Falls back to the current frame if the target has not been posed yet. */
+	bool intersectAsDisplayed(const Ray& ray, float& maxDistance);
+
+	/** Move the target w/o interpolating from its old position (restarting its motion from there) */
+	void teleport(const CFrame& frame) {
+		setFrame(frame);
+		m_previousFrame = m_frame;
+		m_snapPreviousFrame = true;
+		m_motionEpoch++;
+	}
+
+	/** Advance the target's motion model, only changes the entity frame (so it can be used for baking) */
+	virtual void simulateMotion(SimTime absoluteTime, SimTime deltaTime);
 	void setDestinations(const Array<Destination> destinationArray);
 
 };
@@ -162,6 +347,12 @@ protected:
 
 	void init(Vector2 angularSpeedRange, Vector2 motionChangePeriodRange, bool upperHemisphereOnly, Point3 orbitCenter, int paramIdx, Array<bool> axisLock, int respawns = 0, int scaleIdx=0, bool isLogged=true);
 
+	virtual void resetMotionState() override {
+		m_speed = 0.0f;
+		m_destinationPoints.fastClear();
+		m_bounds = AABox();
+	}
+
 public:
 
     /** Destinations must be no more than 170 degrees apart to avoid ambiguity in movement direction */
@@ -204,7 +395,8 @@ public:
 		int								paramIdx,
 		Array<bool>						axisLock,
 		int								respawns=0,
-		bool							isLogged=true);
+		bool							isLogged=true,
+		const shared_ptr<FlyingEntity>&	pooled=nullptr);
 
 	/** Converts the current VisibleEntity to an Any.  Subclasses should
         modify at least the name of the Table returned by the base class, which will be "Entity"
@@ -212,9 +404,75 @@ public:
     virtual Any toAny(const bool forceAll = false) const override;
     
     virtual void onSimulation(SimTime absoluteTime, SimTime deltaTime) override;
+	virtual void simulateMotion(SimTime absoluteTime, SimTime deltaTime) override;
+
+	virtual shared_ptr<TargetEntity> copyMotion() override {
+		const shared_ptr<FlyingEntity>& copy = createShared<FlyingEntity>(*this);
+		initMotionCopy(copy);
+		return copy;
+	}
 };
 
 
+/** Closed-form description of jumping target motion between two consecutive state changes
+	(direction change, jump start/end, or bounds reflection). The position at any time within the
+	segment is evaluated analytically from the segment start, so no per-frame integration is needed. */
+struct JumpSegment {
+	/** Bit flags for the state change(s) that end a segment */
+	enum Event {
+		None			= 0,
+		MotionChange	= 1,
+		JumpStart		= 2,
+		JumpEnd			= 4,
+		Bounce			= 8
+	};
+
+	SimTime	startTime = 0;				///< Entity-local time at which the segment starts (seconds since spawn)
+	float	duration = 0.0f;			///< Segment duration (seconds), i.e. the time until the next state change
+	int		endEvents = None;			///< Event flags for the state change(s) at the end of this segment
+	bool	worldSpace = false;			///< World-space (linear) or player-space (orbit) motion
+	bool	inJump = false;				///< Is the target in a jump during this segment?
+
+	// Vertical (jump) component
+	float	height0 = 0.0f;				///< Height at segment start (absolute in player space, offset above the base position in world space)
+	float	jumpSpeed = 0.0f;			///< Vertical speed at segment start (m/s)
+	float	gravity = 0.0f;				///< Vertical acceleration (m/s^2, negative)
+
+	// World-space component
+	Point3	origin;						///< Base (non-jump) position at segment start
+	Vector3	velocity;					///< Constant velocity of the base position (m/s)
+
+	// Player-space component
+	Point3	orbitCenter;				///< Center of the orbit sphere
+	float	orbitRadius = 0.0f;			///< Radius of the orbit sphere (positions are projected onto it)
+	float	planarRadius = 0.0f;		///< Radius of the horizontal rotation about the orbit center
+	float	angle0 = 0.0f;				///< Horizontal angle (radians) at segment start
+	float	planarSpeed = 0.0f;			///< Horizontal speed at segment start (m/s)
+	float	planarAcc = 0.0f;			///< Horizontal acceleration (m/s^2)
+	float	planarSpeedGoal = 0.0f;		///< Horizontal speed is held at this value once reached
+	float	saturationTime = finf();	///< Time (from segment start) at which planarSpeed reaches planarSpeedGoal
+
+	SimTime endTime() const { return startTime + duration; }
+
+	/** Vertical speed t seconds into the segment */
+	float verticalSpeed(float t) const { return inJump ? jumpSpeed + gravity * t : 0.0f; }
+
+	/** Height (see height0) t seconds into the segment */
+	float height(float t) const { return inJump ? height0 + (jumpSpeed + 0.5f * gravity * t) * t : height0; }
+
+	/** Horizontal speed t seconds into the segment */
+	float planarSpeedAt(float t) const { return (t < saturationTime) ? planarSpeed + planarAcc * t : planarSpeedGoal; }
+
+	/** Horizontal (arc) distance covered t seconds into the segment */
+	float planarDistance(float t) const;
+
+	/** Unprojected player-space position t seconds into the segment */
+	Point3 simulatedPosition(float t) const;
+
+	/** Final target position t seconds into the segment */
+	Point3 position(float t) const;
+};
+
 class JumpingEntity : public TargetEntity {
 protected:
 
@@ -222,6 +480,8 @@ protected:
 	// 1. Spherical component that is horizontal motion only and precisely staying on the spherical surface.
 	// 2. Jump component that target moves vertically following constant acceleration downward (gravity)
 	// 3. If deviated from spherical surface (can be true in jumping cases), project toward orbit center to snap on the spherical surface.
+	// These are solved in closed form for each JumpSegment (the time between state changes), the state below
+	// is only updated (and random draws made) when a segment ends.
 
 	/** Motion kinematic parameters, x is spherical (horizontal) component and y is vertical (jump) component. */
 	Point2			m_speed;
@@ -242,7 +502,7 @@ protected:
 	float			m_jumpTimer;				///< Time remaining in jump (in seconds)
 	
 	bool			m_inJump;					///< In a jump currently?
-	SimTime			m_jumpTime;					///< Time at which a jump started
+	float			m_jumpHeight = 0.0f;		///< Height above the base position in a jump (world space)
 	float           m_standingHeight;			///< Default or "pre-jump" height
 	Vector2			m_angularSpeedRange;		///< Angular Speed Range in deg/s (x=min y=max)
 	Vector2         m_motionChangePeriodRange;	///< Motion Change period in seconds (x=min y=max)
@@ -253,11 +513,38 @@ protected:
 	Vector2         m_distanceRange;
 	float           m_planarAcc = 0.3f;
 	bool            m_isFirstFrame = true;		///< Initializer flag
-	SimTime			m_nextJumpTime = 0;			///< Next time at which to jump
+	SimTime			m_nextJumpTime = 0;			///< Next (local) time at which to jump (world space)
 	
 	AABox			m_bounds = AABox();
 	bool			m_axisLocks[3] = { false };	///< Axis locks (for world space motion)
 
+	static const int MAX_SEGMENTS_PER_FRAME = 256;	///< Limit on state changes processed in a single onSimulation call
+
+	SimTime			m_localTime = 0;			///< Time since motion (re)started
+	JumpSegment		m_segment;					///< Motion segment currently being evaluated
+	float			m_jumpChangeTime = finf();	///< Time from current segment start to the jump start/end
+	uint32			m_motionStartEpoch = 0;		///< Motion epoch the motion was last (re)started in (see resetMotion())
+	Array<JumpSegment> m_segmentLog;			///< Segments started since the last call to takeSegments()
+
+	/** Restart motion from the current frame (first frame, or after the motion epoch changed, i.e. the target was moved) */
+	void resetMotion();
+
+	/** Build m_segment from the current state, starting at local time startTime */
+	void beginSegment(SimTime startTime);
+	void beginWorldSegment(JumpSegment& seg);
+	void beginPlayerSegment(JumpSegment& seg);
+
+	/** Move the state to the end of m_segment, apply its state change(s), and begin the next segment */
+	void nextSegment();
+
+	virtual void resetMotionState() override {
+		m_isFirstFrame = true;
+		m_planarAcc = 0.3f;
+		m_jumpHeight = 0.0f;
+		m_localTime = 0;
+		m_segmentLog.fastClear();
+		m_bounds = AABox();
+	}
 
 	JumpingEntity() {}
 
@@ -283,8 +570,14 @@ protected:
 
 public:
 	bool respawn() {
-		TargetEntity::respawn();
 		m_isFirstFrame = true;
+		return TargetEntity::respawn();
+	}
+
+	/** Get the motion segments started since the last call (for logging), clearing the internal list */
+	void takeSegments(Array<JumpSegment>& segments) {
+		segments.fastClear();
+		m_segmentLog.swap(m_segmentLog, segments);
 	}
 
 	void setBounds(AABox bounds) { m_bounds = bounds; }
@@ -316,7 +609,8 @@ public:
 		int								paramIdx,
 		Array<bool>						axisLock,
 		int								respawns=0,
-		bool							isLogged=true);
+		bool							isLogged=true,
+		const shared_ptr<JumpingEntity>& pooled=nullptr);
 
 	/** Converts the current VisibleEntity to an Any.  Subclasses should
 		modify at least the name of the Table returned by the base class, which will be "Entity"
@@ -324,5 +618,43 @@ public:
 	virtual Any toAny(const bool forceAll = false) const override;
 
 	virtual void onSimulation(SimTime absoluteTime, SimTime deltaTime) override;
+	virtual void simulateMotion(SimTime absoluteTime, SimTime deltaTime) override;
+
+	virtual shared_ptr<TargetEntity> copyMotion() override {
+		const shared_ptr<JumpingEntity>& copy = createShared<JumpingEntity>(*this);
+		initMotionCopy(copy);
+		return copy;
+	}
+};
 
+/** Targets removed from the scene, kept (by type) for reuse by later spawns.
+	Pass a target taken from the pool to the matching create() to re-initialize it instead of allocating a new one. */
+class TargetPool {
+protected:
+	Array<shared_ptr<TargetEntity>>		m_destTargets;		///< Destination (base class) targets
+	Array<shared_ptr<FlyingEntity>>		m_flyingTargets;	///< Flying targets
+	Array<shared_ptr<JumpingEntity>>	m_jumpingTargets;	///< Jumping targets
+
+	template <class T>
+	static shared_ptr<T> take(Array<shared_ptr<T>>& targets) {
+		if (targets.size() == 0) return nullptr;
+		return targets.pop();
+	}
+
+public:
+	/** Get a pooled target of the given type (returns nullptr if there are none) */
+	shared_ptr<TargetEntity> takeDestTarget() { return take(m_destTargets); }
+	shared_ptr<FlyingEntity> takeFlyingTarget() { return take(m_flyingTargets); }
+	shared_ptr<JumpingEntity> takeJumpingTarget() { return take(m_jumpingTargets); }
+
+	/** Return a target (already removed from the scene) to the pool */
+	void release(const shared_ptr<TargetEntity>& target);
+
+	int size() const { return m_destTargets.size() + m_flyingTargets.size() + m_jumpingTargets.size(); }
+
+	void clear() {
+		m_destTargets.clear();
+		m_flyingTargets.clear();
+		m_jumpingTargets.clear();
+	}
 };
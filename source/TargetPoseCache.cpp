@@ -0,0 +1,59 @@
+#include "TargetPoseCache.h"
+
+uint32 TargetPoseCache::key(const Color3& color) {
+	// 10 bits per channel (so emissive colors up to ~4x white don't collide)
+	const uint32 r = clamp(iRound(color.r * 255.0f), 0, 1023);
+	const uint32 g = clamp(iRound(color.g * 255.0f), 0, 1023);
+	const uint32 b = clamp(iRound(color.b * 255.0f), 0, 1023);
+	return (r << 20) | (g << 10) | b;
+}
+
+shared_ptr<ArticulatedModel::Pose> TargetPoseCache::createPose(const Color3& color) {
+	UniversalMaterial::Specification materialSpecification;
+	materialSpecification.setLambertian(Texture::Specification(color));
+	materialSpecification.setEmissive(Texture::Specification(color * 0.7f));
+	materialSpecification.setGlossy(Texture::Specification(Color4(0.4f, 0.2f, 0.1f, 0.8f)));
+
+	const shared_ptr<ArticulatedModel::Pose>& amPose = ArticulatedModel::Pose::create();
+	amPose->materialTable.set("core/icosahedron_default", UniversalMaterial::create(materialSpecification));
+	return amPose;
+}
+
+shared_ptr<ArticulatedModel::Pose> TargetPoseCache::pose(const Color3& color) {
+	const uint32 k = key(color);
+	m_useCount++;
+	Entry* cached = m_poses.getPointer(k);
+	if (notNull(cached)) {
+		cached->lastUse = m_useCount;
+		return cached->pose;
+	}
+
+	// Evict the least recently used pose to stay within the size limit (targets using it keep their reference),
+	// the scan only runs on a miss in a full cache, which creates a material anyway
+	if (m_poses.size() >= m_maxSize) {
+		uint32 lruKey = 0;
+		uint64 lruUse = UINT64_MAX;
+		for (const Table<uint32, Entry>::Entry& e : m_poses) {
+			if (e.value.lastUse < lruUse) {
+				lruUse = e.value.lastUse;
+				lruKey = e.key;
+			}
+		}
+		m_poses.remove(lruKey);
+	}
+
+	Entry entry;
+	entry.pose = createPose(color);
+	entry.lastUse = m_useCount;
+	m_poses.set(k, entry);
+	return entry.pose;
+}
+
+void TargetPoseCache::setHealthColors(const Array<Color3>& colors, int levels) {
+	alwaysAssertM(colors.size() >= 2, "Target health colors must include at least 2 colors!");
+	m_healthPoses.fastClear();
+	for (int i = 0; i < levels; i++) {
+		const float complete = (float)i / levels;
+		m_healthPoses.append(pose(colors[0] * complete + colors[1] * (1.0f - complete)));
+	}
+}
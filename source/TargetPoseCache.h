@@ -0,0 +1,49 @@
+#pragma once
+#include <G3D/G3D.h>
+
+/** Bounded cache of target poses keyed by (quantized) color. Each pose sets the target material for its color,
+	so spawning and hit feedback share prebuilt poses rather than creating a material (and pose) for each event.
+	When full, the least recently used pose is evicted. Poses handed out by the cache are shared between targets and must not be modified. */
+class TargetPoseCache : public ReferenceCountedObject {
+protected:
+	struct Entry {
+		shared_ptr<ArticulatedModel::Pose>	pose;
+		uint64								lastUse = 0;		///< Value of m_useCount when the pose was last handed out
+	};
+
+	int												m_maxSize;			///< Maximum number of (non-health level) poses kept
+	Table<uint32, Entry>							m_poses;			///< Poses by quantized color
+	uint64											m_useCount = 0;		///< Number of pose() calls (orders the entries by use)
+	Array<shared_ptr<ArticulatedModel::Pose>>		m_healthPoses;		///< Poses by health level (lowest to highest)
+
+	TargetPoseCache(int maxSize) : m_maxSize(maxSize) {}
+
+	/** Quantize a color (to 1/255 steps, 10 bits per channel so channels up to ~4 don't collide) for use as a key */
+	static uint32 key(const Color3& color);
+
+	static shared_ptr<ArticulatedModel::Pose> createPose(const Color3& color);
+
+public:
+	static shared_ptr<TargetPoseCache> create(int maxSize = 256) {
+		return createShared<TargetPoseCache>(maxSize);
+	}
+
+	/** Get the (shared) pose for a target of the given color, creating it if it isn't cached */
+	shared_ptr<ArticulatedModel::Pose> pose(const Color3& color);
+
+	/** Build the health level poses, interpolating from colors[0] (full health) to colors[1] (no health) */
+	void setHealthColors(const Array<Color3>& colors, int levels);
+
+	/** Get the pose for a target w/ the given health (in [0,1]) */
+	const shared_ptr<ArticulatedModel::Pose>& healthPose(float health) const {
+		const int level = clamp((int)(health * m_healthPoses.size()), 0, m_healthPoses.size() - 1);
+		return m_healthPoses[level];
+	}
+
+	int size() const { return m_poses.size(); }
+
+	void clear() {
+		m_poses.clear();
+		m_healthPoses.clear();
+	}
+};
@@ -0,0 +1,87 @@
+#include "TaskGraph.h"
+#include <thread>
+
+int TaskGraph::indexOf(const String& name) const {
+	for (int i = 0; i < m_tasks.size(); i++) {
+		if (m_tasks[i].name == name) return i;
+	}
+	return -1;
+}
+
+void TaskGraph::add(const String& name, Affinity affinity, const std::function<void()>& fn, const Array<String>& dependencies) {
+	if (indexOf(name) >= 0) {
+		throw format("Task \"%s\" was added twice!", name.c_str());
+	}
+	Task task;
+	task.name = name;
+	task.affinity = affinity;
+	task.fn = fn;
+	for (const String& dep : dependencies) {
+		const int idx = indexOf(dep);
+		if (idx < 0) {
+			throw format("Task \"%s\" depends on \"%s\", which has not been added!", name.c_str(), dep.c_str());
+		}
+		task.level = max(task.level, m_tasks[idx].level + 1);
+	}
+	m_tasks.append(task);
+}
+
+void TaskGraph::run(const shared_ptr<JobPool>& pool) {
+	const RealTime start = System::time();
+	int maxLevel = -1;
+	for (const Task& task : m_tasks) {
+		maxLevel = max(maxLevel, task.level);
+	}
+
+	for (int level = 0; level <= maxLevel; level++) {
+		Array<Task*> workerTasks;
+		Array<Task*> mainTasks;
+		for (Task& task : m_tasks) {
+			if (task.level != level) continue;
+			(task.affinity == Affinity::Worker ? workerTasks : mainTasks).append(&task);
+		}
+
+		auto runTask = [start](Task* task) {
+			task->start = System::time() - start;
+			task->fn();
+			task->duration = System::time() - start - task->start;
+		};
+
+		// Drive the pool from a helper thread so this (main) thread is free for the main thread tasks
+		std::exception_ptr workerError;
+		std::thread workers([&]() {
+			try {
+				pool->parallelFor(workerTasks.size(), [&](int i) { runTask(workerTasks[i]); });
+			}
+			catch (...) {
+				workerError = std::current_exception();
+			}
+		});
+
+		std::exception_ptr mainError;
+		try {
+			for (Task* task : mainTasks) {
+				runTask(task);
+			}
+		}
+		catch (...) {
+			mainError = std::current_exception();
+		}
+		workers.join();
+
+		if (mainError) std::rethrow_exception(mainError);
+		if (workerError) std::rethrow_exception(workerError);
+	}
+	m_totalTime = System::time() - start;
+}
+
+void TaskGraph::logTimings(const String& title) const {
+	RealTime serialTime = 0.0;
+	logPrintf("%s task timings:\n", title.c_str());
+	for (const Task& task : m_tasks) {
+		logPrintf("\t%-24s %8.1f ms (level %d, %s, started at %.1f ms)\n", task.name.c_str(), 1000.0 * task.duration, task.level,
+			task.affinity == Affinity::Main ? "main" : "worker", 1000.0 * task.start);
+		serialTime += task.duration;
+	}
+	logPrintf("\ttotal %.1f ms (%.1f ms if run serially)\n", 1000.0 * m_totalTime, 1000.0 * serialTime);
+}
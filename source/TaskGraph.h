@@ -0,0 +1,41 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <functional>
+#include "JobPool.h"
+
+/** Runs a set of named tasks w/ dependencies (used to load configs and assets on startup).
+	Tasks are grouped into levels by dependency depth. Within a level, worker tasks run concurrently on a job pool while the main
+	thread runs the level's main thread tasks (anything touching the GL context or UI), then the next level starts.
+	Each task is timed so the startup cost can be broken down in the log. */
+class TaskGraph {
+public:
+	enum class Affinity {
+		Worker,			///< Runs on the job pool (must not touch the GL context)
+		Main			///< Runs on the calling (main) thread
+	};
+
+protected:
+	struct Task {
+		String					name;
+		Affinity				affinity;
+		std::function<void()>	fn;
+		int						level = 0;			///< Dependency depth (tasks w/o dependencies are level 0)
+		RealTime				start = 0.0;		///< Start time (relative to the start of run())
+		RealTime				duration = 0.0;
+	};
+
+	Array<Task>				m_tasks;
+	RealTime				m_totalTime = 0.0;
+
+	int indexOf(const String& name) const;
+
+public:
+	/** Add a task, dependencies must already have been added (so there can be no cycles) */
+	void add(const String& name, Affinity affinity, const std::function<void()>& fn, const Array<String>& dependencies = Array<String>());
+
+	/** Run all tasks, returning once they are complete. The first exception thrown by a task is rethrown here (after its level completes). */
+	void run(const shared_ptr<JobPool>& pool);
+
+	/** Write the per task timings to the log */
+	void logTimings(const String& title) const;
+};
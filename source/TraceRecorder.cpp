@@ -0,0 +1,178 @@
+#include "TraceRecorder.h"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+std::atomic<bool> TraceRecorder::s_recording(false);
+
+namespace {
+	struct TraceEvent {
+		const char*		name;
+		int64			timeNs;
+		char			phase;				///< 'B' (begin) or 'E' (end)
+	};
+
+	/** One thread's events. Buffers of threads that exit while recording are kept (retired) until the trace is written. */
+	struct ThreadBuffer {
+		int						tid;
+		const char*				name;
+		bool					retired = false;		///< Has the owning thread exited? (guarded by s_buffersMutex)
+		std::atomic<uint64>		count;					///< Events recorded (the latest EventsPerThread are in events)
+		uint64					startCount = 0;			///< Value of count when recording started
+		TraceEvent				events[TraceRecorder::EventsPerThread];
+		ThreadBuffer(int id, const char* threadName) : tid(id), name(threadName), count(0) {}
+	};
+
+	std::mutex					s_buffersMutex;			///< Guards s_buffers
+	Array<ThreadBuffer*>		s_buffers;
+	std::thread					s_writer;
+	std::atomic<int>			s_nextTid(1);
+
+	/** Free the retired buffers (caller holds s_buffersMutex) */
+	void freeRetiredBuffers() {
+		for (int i = 0; i < s_buffers.size(); i++) {
+			if (s_buffers[i]->retired) {
+				delete s_buffers[i];
+				s_buffers.fastRemove(i);
+				i--;
+			}
+		}
+	}
+
+	/** Per-thread state, the buffer is released when the thread exits */
+	struct ThreadSlot {
+		int				tid = 0;
+		const char*		name = nullptr;
+		ThreadBuffer*	buffer = nullptr;
+
+		~ThreadSlot() {
+			if (isNull(buffer)) return;
+			std::lock_guard<std::mutex> lk(s_buffersMutex);
+			buffer->retired = true;
+			if (!TraceRecorder::recording()) {
+				freeRetiredBuffers();
+			}
+		}
+	};
+	thread_local ThreadSlot		t_slot;
+
+	int threadId() {
+		if (t_slot.tid == 0) {
+			t_slot.tid = s_nextTid++;
+		}
+		return t_slot.tid;
+	}
+
+	ThreadBuffer* threadBuffer() {
+		if (isNull(t_slot.buffer)) {
+			ThreadBuffer* buffer = new ThreadBuffer(threadId(), t_slot.name);
+			std::lock_guard<std::mutex> lk(s_buffersMutex);
+			s_buffers.append(buffer);
+			t_slot.buffer = buffer;
+		}
+		return t_slot.buffer;
+	}
+
+	int64 nowNs() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+void TraceRecorder::setThreadName(const char* name) {
+	t_slot.name = name;
+	if (notNull(t_slot.buffer)) {
+		std::lock_guard<std::mutex> lk(s_buffersMutex);
+		t_slot.buffer->name = name;
+	}
+}
+
+void TraceRecorder::record(const char* name, char phase) {
+	ThreadBuffer* buffer = threadBuffer();
+	const uint64 i = buffer->count.load(std::memory_order_relaxed);
+	TraceEvent& e = buffer->events[i % EventsPerThread];
+	e.name = name;
+	e.timeNs = nowNs();
+	e.phase = phase;
+	buffer->count.store(i + 1, std::memory_order_release);
+}
+
+void TraceRecorder::start() {
+	{
+		std::lock_guard<std::mutex> lk(s_buffersMutex);
+		for (ThreadBuffer* buffer : s_buffers) {
+			buffer->startCount = buffer->count.load(std::memory_order_acquire);
+		}
+	}
+	s_recording.store(true);
+}
+
+void TraceRecorder::stopAndWrite(const String& filename) {
+	s_recording.store(false);
+
+	// Copy the events out (a thread may still be finishing one event, so leave a little slack at the old end of each ring)
+	static const uint64 slack = 64;
+	struct ThreadEvents {
+		int					tid;
+		const char*			name;
+		Array<TraceEvent>	events;
+	};
+	shared_ptr<Array<ThreadEvents>> threads = std::make_shared<Array<ThreadEvents>>();
+	{
+		std::lock_guard<std::mutex> lk(s_buffersMutex);
+		for (ThreadBuffer* buffer : s_buffers) {
+			const uint64 end = buffer->count.load(std::memory_order_acquire);
+			const uint64 begin = max(buffer->startCount, (end > EventsPerThread - slack) ? end - (EventsPerThread - slack) : 0);
+			if (end <= begin) continue;
+			ThreadEvents& t = threads->next();
+			t.tid = buffer->tid;
+			t.name = buffer->name;
+			t.events.reserve(int(end - begin));
+			for (uint64 i = begin; i < end; i++) {
+				t.events.append(buffer->events[i % EventsPerThread]);
+			}
+		}
+		freeRetiredBuffers();
+	}
+
+	// Write the JSON off the calling thread
+	shutdown();
+	s_writer = std::thread([threads, filename]() {
+		FILE* f = fopen(filename.c_str(), "w");
+		if (isNull(f)) {
+			logPrintf("Could not write trace file %s\n", filename.c_str());
+			return;
+		}
+		int64 t0 = std::numeric_limits<int64>::max();
+		for (const ThreadEvents& t : *threads) {
+			t0 = min(t0, t.events[0].timeNs);
+		}
+		fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		bool first = true;
+		for (const ThreadEvents& t : *threads) {
+			if (notNull(t.name)) {
+				fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", t.tid, t.name);
+				first = false;
+			}
+			for (const TraceEvent& e : t.events) {
+				const double ts = double(e.timeNs - t0) / 1000.0;
+				if (e.phase == 'B') {
+					fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"B\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", first ? "" : ",\n", e.name, t.tid, ts);
+				}
+				else {
+					fprintf(f, "%s{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", first ? "" : ",\n", t.tid, ts);
+				}
+				first = false;
+			}
+		}
+		fprintf(f, "\n]}\n");
+		fclose(f);
+		logPrintf("Wrote trace file %s\n", filename.c_str());
+	});
+}
+
+void TraceRecorder::shutdown() {
+	if (s_writer.joinable()) {
+		s_writer.join();
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <G3D/G3D.h>
+#include <atomic>
+
+/** Records begin/end events from any thread into per-thread ring buffers, and writes them out as a Chrome trace
+	(JSON, viewable in chrome://tracing or Perfetto). Recording is off by default, when off an event costs one atomic load.
+	A thread's ring buffer is only allocated when it records its first event, and is freed when the thread exits
+	(once its events have been written, if it exits while recording). Event and thread names must be string literals
+	(only the pointer is stored). */
+class TraceRecorder {
+public:
+	static const int EventsPerThread = 64 * 1024;		///< Ring buffer size per thread (older events are overwritten)
+
+	/** Name the calling thread in traces */
+	static void setThreadName(const char* name);
+
+	static void begin(const char* name) { if (s_recording.load(std::memory_order_relaxed)) record(name, 'B'); }
+	static void end() { if (s_recording.load(std::memory_order_relaxed)) record(nullptr, 'E'); }
+
+	/** Start recording (clearing any previously recorded events) */
+	static void start();
+	static bool recording() { return s_recording.load(std::memory_order_relaxed); }
+
+	/** Stop recording and write the recorded events to filename (the file is written on a background thread) */
+	static void stopAndWrite(const String& filename);
+
+	/** Wait for any trace being written to finish */
+	static void shutdown();
+
+protected:
+	static std::atomic<bool> s_recording;
+
+	static void record(const char* name, char phase);
+};
+
+/** Profiler event that is also captured by the TraceRecorder */
+#define BEGIN_TRACE_EVENT(name) do { BEGIN_PROFILER_EVENT(name); TraceRecorder::begin(name); } while (0)
+#define END_TRACE_EVENT() do { END_PROFILER_EVENT(); TraceRecorder::end(); } while (0)
@@ -35,15 +35,20 @@ Array<Array<String>> select_stmt(sqlite3* db, String stmt)
 	return output;
 }
 
-void sql_stmt(sqlite3* db, String stmt)
+void sql_stmt(sqlite3* db, const char* stmt)
 {
 	char *errmsg;
-	int ret = sqlite3_exec(db, stmt.c_str(), 0, 0, &errmsg);
+	int ret = sqlite3_exec(db, stmt, 0, 0, &errmsg);
 	if (ret != SQLITE_OK) {
 		fprintf(stderr, "Error in select statement: %s\n", errmsg);
 	}
 }
 
+void sql_stmt(sqlite3* db, String stmt)
+{
+	sql_stmt(db, stmt.c_str());
+}
+
 /////// SQLite Front-End Helpers ///////
 void createTableInDB(sqlite3* db, String tableName, Array<Array<String>> columns)
 {
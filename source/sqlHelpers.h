@@ -7,6 +7,7 @@
 #include <sstream>
 
 
+void sql_stmt(sqlite3* db, const char* stmt);
 void createTableInDB(sqlite3* db, String tableName, Array<Array<String>> columns);
 void insertRowIntoDB(sqlite3* db, String tableName, Array<String> values, String colNames = "");
 void insertRowsIntoDB(sqlite3* db, String tableName, Array<Array<String>> valueVector, String colNames = "");